@@ -4,12 +4,14 @@
 
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " local_player\n";
+    if (argc != 2 && !(argc == 3 && std::string(argv[2]) == "computer")) {
+        std::cerr << "Usage: " << argv[0] << " local_player [computer]\n";
             return -1;
         }
         int local_player = std::stoi(argv[1]);
-        std::unique_ptr<ash::Game_loop> game_loop(new ash::Server_loop(local_player, 18000));
+        bool computer_opponent = argc == 3;
+        std::unique_ptr<ash::Game_loop> game_loop(new ash::Server_loop(
+                    local_player, 18000, computer_opponent));
         try {
             game_loop->run();
     } catch (ash::Network_error& e) {
@@ -0,0 +1,152 @@
+#include "benchmark_support.hpp"
+#include "physics.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+
+namespace {
+
+using ash::benchmark::Random_player;
+using ash::benchmark::same_bits;
+
+// Plays the same match with and without the contact cache and compares the
+// states bit by bit after every tick.
+size_t compare(ash::Environment::Substepping substepping, size_t ticks,
+        ash::Environment::Contact_stats_array& stats) {
+    ash::Environment plain, cached;
+    plain.set_substepping(substepping);
+    cached.set_substepping(substepping);
+    plain.set_contact_cache(false);
+    stats = {};
+    cached.set_contact_stats(&stats);
+    Random_player players[] = {Random_player(0, 1), Random_player(1, 2)};
+    size_t sender = 0;
+    size_t mismatches = 0;
+    for (size_t t = 0; t < ticks; ++t) {
+        auto state = plain.get_state();
+        auto a1 = players[0].get_action(state);
+        auto a2 = players[1].get_action(state);
+        int plain_winner = plain.step(a1, a2);
+        int cached_winner = cached.step(a1, a2);
+        if (plain_winner != cached_winner ||
+                !same_bits(plain.get_state(), cached.get_state())) {
+            ++mismatches;
+            cached.set_state(plain.get_state());
+        }
+        if (plain_winner != -1) {
+            sender = 1 - sender;
+            plain.reset(sender);
+            cached.reset(sender);
+        }
+    }
+    return mismatches;
+}
+
+// The same, stepping once from states of a match with a strong force left
+// pending on one of the bodies (as apply_force or a restored snapshot
+// leave it).
+size_t compare_pending(size_t cases) {
+    ash::Environment plain, cached;
+    plain.set_contact_cache(false);
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> magnitude(500, 4500);
+    std::uniform_real_distribution<double> component(-1, 1);
+    std::uniform_int_distribution<size_t> body(0, 2);
+    Random_player players[] = {Random_player(0, 1), Random_player(1, 2)};
+    size_t sender = 0;
+    size_t mismatches = 0;
+    for (size_t c = 0; c < cases; ++c) {
+        auto state = plain.get_state();
+        auto a1 = players[0].get_action(state);
+        auto a2 = players[1].get_action(state);
+        ash::Vector_2d direction(component(rng), component(rng));
+        auto snapshot = plain.get_snapshot();
+        size_t i = body(rng);
+        (i < 2? snapshot.mallets[i] : snapshot.puck).force =
+            magnitude(rng)/direction.norm()*direction;
+        plain.restore(snapshot);
+        cached.restore(snapshot);
+        int plain_winner = plain.step(a1, a2);
+        int cached_winner = cached.step(a1, a2);
+        if (plain_winner != cached_winner ||
+                !same_bits(plain.get_state(), cached.get_state())) {
+            ++mismatches;
+        }
+        if (plain_winner != -1) {
+            sender = 1 - sender;
+            plain.reset(sender);
+            cached.reset(sender);
+        }
+    }
+    return mismatches;
+}
+
+double measure(ash::Environment::Substepping substepping, bool contact_cache,
+        size_t ticks) {
+    ash::Environment env;
+    env.set_substepping(substepping);
+    env.set_contact_cache(contact_cache);
+    return ash::benchmark::random_steps_per_second(env, ticks);
+}
+
+const char* pair_name(size_t pair) {
+    if (pair < 12) {
+        return "wall x mallet";
+    }
+    if (pair < 18) {
+        return "barrier x mallet";
+    }
+    if (pair < 24) {
+        return "wall x puck";
+    }
+    return "mallet x puck";
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    using Substepping = ash::Environment::Substepping;
+    size_t ticks = argc > 1? std::stoul(argv[1]) : 200000;
+
+    size_t total_mismatches = 0;
+    for (auto substepping : {Substepping::fixed, Substepping::adaptive}) {
+        ash::Environment::Contact_stats_array stats;
+        size_t mismatches = compare(substepping, ticks, stats);
+        total_mismatches += mismatches;
+        double plain_rate = measure(substepping, false, ticks);
+        double cached_rate = measure(substepping, true, ticks);
+        std::cout << (substepping == Substepping::fixed? "fixed" : "adaptive")
+                  << ", " << ticks << " ticks: " << mismatches
+                  << " mismatches, " << std::fixed << std::setprecision(0)
+                  << plain_rate << " step/s without cache, " << cached_rate
+                  << " step/s with cache (" << std::setprecision(2)
+                  << cached_rate/plain_rate << "x)" << std::endl;
+        std::cout << std::setw(6) << "pair"
+                  << std::setw(18) << "bodies"
+                  << std::setw(12) << "skipped"
+                  << std::setw(12) << "tested"
+                  << std::setw(12) << "contacts"
+                  << std::setw(10) << "hit rate" << std::endl;
+        for (size_t i = 0; i < stats.size(); ++i) {
+            size_t total = stats[i].skipped + stats[i].tested;
+            std::cout << std::setw(6) << i
+                      << std::setw(18) << pair_name(i)
+                      << std::setw(12) << stats[i].skipped
+                      << std::setw(12) << stats[i].tested
+                      << std::setw(12) << stats[i].contacts
+                      << std::setw(9) << std::setprecision(1)
+                      << (total? 100.0*stats[i].skipped/total : 0.0) << "%"
+                      << std::endl;
+        }
+    }
+    size_t cases = std::min<size_t>(ticks, 20000);
+    size_t mismatches = compare_pending(cases);
+    total_mismatches += mismatches;
+    std::cout << "pending forces, " << cases << " cases: " << mismatches
+              << " mismatches" << std::endl;
+    return total_mismatches == 0? 0 : 1;
+}
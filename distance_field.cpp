@@ -0,0 +1,70 @@
+#include "distance_field.hpp"
+#include "fixed_point.hpp"
+#include "dual.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+template<class Scalar>
+Scalar ash::signed_distance(const Basic_aabb<Scalar>& box,
+        const Basic_vector_2d<Scalar>& point) {
+    Scalar cx = (box.x_min + box.x_max)/2;
+    Scalar cy = (box.y_min + box.y_max)/2;
+    using std::abs;
+    Scalar dx = abs(point.x - cx) - (box.x_max - box.x_min)/2;
+    Scalar dy = abs(point.y - cy) - (box.y_max - box.y_min)/2;
+    Scalar outside = Basic_vector_2d<Scalar>(
+            std::max(dx, Scalar(0)), std::max(dy, Scalar(0))).norm();
+    Scalar inside = std::min(std::max(dx, dy), Scalar(0));
+    return outside + inside;
+}
+
+template<class Scalar>
+ash::Basic_distance_field<Scalar>::Basic_distance_field(
+        const std::vector<AABB>& boxes, const AABB& bounds,
+        Scalar resolution) :
+    bounds(bounds), resolution(resolution), inv_resolution(1/resolution)
+{
+    // one extra sample so that every covered point has four neighbours
+    using std::ceil;
+    columns = static_cast<size_t>(static_cast<double>(
+            ceil((bounds.x_max - bounds.x_min)/resolution))) + 1;
+    rows = static_cast<size_t>(static_cast<double>(
+            ceil((bounds.y_max - bounds.y_min)/resolution))) + 1;
+    distances.resize(rows*columns);
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < columns; ++j) {
+            Vector_2d point(bounds.x_min + j*resolution,
+                    bounds.y_min + i*resolution);
+            Scalar distance = std::numeric_limits<Scalar>::infinity();
+            for (const auto& box : boxes) {
+                distance = std::min(distance, signed_distance(box, point));
+            }
+            distances[i*columns + j] = static_cast<float>(distance);
+        }
+    }
+}
+
+template<class Scalar>
+typename ash::Basic_distance_field<Scalar>::Sample
+ash::Basic_distance_field<Scalar>::lookup(const Vector_2d& point) const {
+    Cell cell = locate(point);
+    const auto& d = cell.d;
+    Scalar fx = cell.fx;
+    Scalar fy = cell.fy;
+    Sample out;
+    out.distance = (d[0]*(1 - fx) + d[1]*fx)*(1 - fy) +
+                   (d[2]*(1 - fx) + d[3]*fx)*fy;
+    // gradient of the bilinear patch
+    Vector_2d gradient((d[1] - d[0])*(1 - fy) + (d[3] - d[2])*fy,
+                       (d[2] - d[0])*(1 - fx) + (d[3] - d[1])*fx);
+    Scalar norm = gradient.norm();
+    out.normal = norm > 0? gradient/norm : Vector_2d(1, 0);
+    return out;
+}
+
+template class ash::Basic_distance_field<double>;
+template class ash::Basic_distance_field<float>;
+template class ash::Basic_distance_field<ash::Fixed>;
+template class ash::Basic_distance_field<ash::Dual_scalar>;
@@ -0,0 +1,111 @@
+#include "physics.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// what a tree search keeps around: a few thousand nodes, each of them an
+// environment
+constexpr size_t node_count = 4096;
+
+template<class Environment>
+double measure_construction(size_t count) {
+    std::vector<Environment> nodes(node_count);
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        nodes[i % node_count] = Environment();
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return count/elapsed.count();
+}
+
+// Copies a handful of different environments all over the nodes, the way
+// an expansion copies its parent before stepping it.
+template<class Environment>
+double measure_copy(size_t count) {
+    typedef typename Environment::Action Action;
+    std::vector<Environment> parents(16);
+    for (size_t i = 0; i < parents.size(); ++i) {
+        for (size_t t = 0; t < i; ++t) {
+            parents[i].step(Action(ash::Vector_2d(-0.5, 0.1*t)),
+                    Action(ash::Vector_2d(0.5, -0.1*t)));
+        }
+    }
+    std::vector<Environment> nodes(node_count);
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        nodes[(i*7) % node_count] = parents[i % parents.size()];
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    // so that the copies are not optimized away
+    double sum = 0;
+    for (const auto& node : nodes) {
+        sum += static_cast<double>(node.get_puck().get_position().x);
+    }
+    if (sum == 12345) {
+        std::cout << sum << std::endl;
+    }
+    return count/elapsed.count();
+}
+
+// copy a random node and step it once with random actions
+template<class Environment>
+double measure_expansion(size_t count) {
+    using namespace ::ash::parameters;
+    typedef typename Environment::Action Action;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> x(0.1, field_length/2);
+    std::uniform_real_distribution<double> y(-field_width/2, field_width/2);
+    std::uniform_int_distribution<size_t> node(0, node_count - 1);
+    std::vector<Environment> nodes(node_count);
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        auto& child = nodes[node(rng)];
+        child = nodes[node(rng)];
+        Action a1(ash::Vector_2d(-x(rng), y(rng)));
+        Action a2(ash::Vector_2d(x(rng), y(rng)));
+        if (child.step(a1, a2) != -1) {
+            child.reset(i % 2);
+        }
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return count/elapsed.count();
+}
+
+template<class Environment>
+void report(const char* name, size_t count) {
+    std::cout << std::fixed << std::setprecision(0)
+              << std::setw(20) << name
+              << std::setw(8) << sizeof(Environment)
+              << std::setw(14) << measure_construction<Environment>(count)
+              << std::setw(14) << measure_copy<Environment>(count)
+              << std::setw(14) << measure_expansion<Environment>(count/10)
+              << std::endl;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t count = argc > 1? std::stoul(argv[1]) : 10000000;
+
+    std::cout << count << " constructions and copies, " << count/10
+              << " expansions, " << node_count << " nodes" << std::endl;
+    std::cout << std::setw(20) << "environment"
+              << std::setw(8) << "bytes"
+              << std::setw(14) << "construct/s"
+              << std::setw(14) << "copy/s"
+              << std::setw(14) << "expand/s" << std::endl;
+    report<ash::Environment>("Environment", count);
+    report<ash::Float_environment>("Float_environment", count);
+    report<ash::Fixed_environment>("Fixed_environment", count);
+    report<ash::Runtime_environment>("Runtime_environment", count);
+    return 0;
+}
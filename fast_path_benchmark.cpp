@@ -0,0 +1,131 @@
+#include "benchmark_support.hpp"
+#include "physics.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <utility>
+
+
+namespace {
+
+using ash::benchmark::Random_player;
+using ash::benchmark::same_bits;
+
+typedef ash::Environment::Integrator Integrator;
+
+struct Configuration {
+    const char* name;
+    ash::Environment::Substepping substepping;
+    ash::Environment::Collision_detection collision_detection;
+    int fixed_substeps;
+};
+
+void configure(ash::Environment& env, Integrator integrator,
+        const Configuration& configuration, bool fast_path) {
+    env.set_integrator(integrator);
+    env.set_substepping(configuration.substepping);
+    env.set_collision_detection(configuration.collision_detection);
+    env.set_fixed_substeps(configuration.fixed_substeps);
+    env.set_fast_path(fast_path);
+}
+
+// Plays the same match with and without the fast path and compares the
+// states bit by bit after every tick.
+size_t compare(Integrator integrator, const Configuration& configuration,
+        size_t ticks, size_t& fast_ticks) {
+    ash::Environment slow, fast;
+    configure(slow, integrator, configuration, false);
+    configure(fast, integrator, configuration, true);
+    Random_player players[] = {Random_player(0, 1), Random_player(1, 2)};
+    size_t sender = 0;
+    size_t mismatches = 0;
+    fast_ticks = 0;
+    for (size_t t = 0; t < ticks; ++t) {
+        auto state = slow.get_state();
+        auto a1 = players[0].get_action(state);
+        auto a2 = players[1].get_action(state);
+        int slow_winner = slow.step(a1, a2);
+        int fast_winner = fast.step(a1, a2);
+        fast_ticks += fast.get_last_fast_path();
+        if (slow_winner != fast_winner ||
+                !same_bits(slow.get_state(), fast.get_state())) {
+            ++mismatches;
+            fast.set_state(slow.get_state());
+        }
+        if (slow_winner != -1) {
+            sender = 1 - sender;
+            slow.reset(sender);
+            fast.reset(sender);
+        }
+    }
+    return mismatches;
+}
+
+double measure(Integrator integrator, const Configuration& configuration,
+        bool fast_path, size_t ticks) {
+    ash::Environment env;
+    configure(env, integrator, configuration, fast_path);
+    return ash::benchmark::random_steps_per_second(env, ticks);
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    using Substepping = ash::Environment::Substepping;
+    using Collision_detection = ash::Environment::Collision_detection;
+    size_t ticks = argc > 1? std::stoul(argv[1]) : 200000;
+
+    using namespace ::ash::parameters;
+    // the fast path only applies to semi-implicit Euler, the other
+    // integrators are there to check that it stays out of their way
+    const std::pair<const char*, Integrator> integrators[] = {
+        {"euler", Integrator::semi_implicit_euler},
+        {"verlet", Integrator::velocity_verlet},
+        {"runge-kutta", Integrator::runge_kutta},
+    };
+    const Configuration configurations[] = {
+        {"fixed", Substepping::fixed, Collision_detection::discrete,
+            substeps},
+        {"fixed 2", Substepping::fixed, Collision_detection::discrete, 2},
+        {"fixed 1", Substepping::fixed, Collision_detection::discrete, 1},
+        {"fixed swept", Substepping::fixed, Collision_detection::swept,
+            substeps},
+        {"adaptive", Substepping::adaptive, Collision_detection::discrete,
+            substeps},
+        {"adaptive swept", Substepping::adaptive,
+            Collision_detection::swept, substeps},
+    };
+    std::cout << ticks << " ticks" << std::endl;
+    std::cout << std::setw(12) << "integrator"
+              << std::setw(16) << "mode"
+              << std::setw(12) << "mismatches"
+              << std::setw(12) << "fast ticks"
+              << std::setw(14) << "slow step/s"
+              << std::setw(14) << "fast step/s"
+              << std::setw(10) << "speedup" << std::endl;
+    size_t total_mismatches = 0;
+    for (const auto& [integrator_name, integrator] : integrators) {
+        for (const auto& configuration : configurations) {
+            size_t fast_ticks;
+            size_t mismatches = compare(integrator, configuration, ticks,
+                    fast_ticks);
+            total_mismatches += mismatches;
+            double slow_rate = measure(integrator, configuration, false,
+                    ticks);
+            double fast_rate = measure(integrator, configuration, true,
+                    ticks);
+            std::cout << std::fixed
+                      << std::setw(12) << integrator_name
+                      << std::setw(16) << configuration.name
+                      << std::setw(12) << mismatches
+                      << std::setw(11) << std::setprecision(1)
+                      << 100.0*fast_ticks/ticks << "%"
+                      << std::setw(14) << std::setprecision(0) << slow_rate
+                      << std::setw(14) << fast_rate
+                      << std::setw(10) << std::setprecision(2)
+                      << fast_rate/slow_rate << std::endl;
+        }
+    }
+    return total_mismatches == 0? 0 : 1;
+}
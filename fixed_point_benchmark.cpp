@@ -0,0 +1,103 @@
+#include "physics.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Targets drawn with integer arithmetic only (the distributions of the
+// standard library differ between implementations), held for 5 to 50
+// ticks. Coordinates are in units of 2^-16 m, so that they are exact in
+// every precision.
+std::vector<std::array<ash::Vector_2d,2>> make_schedule(size_t ticks) {
+    using namespace ::ash::parameters;
+    std::mt19937_64 rng(1);
+    auto draw = [&](double lo, double hi) {
+        auto steps = static_cast<std::uint64_t>((hi - lo)*65536);
+        return lo + static_cast<double>(rng()%steps)/65536;
+    };
+    std::vector<std::array<ash::Vector_2d,2>> schedule(ticks);
+    std::array<ash::Vector_2d,2> targets;
+    std::uint64_t left = 0;
+    for (auto& actions : schedule) {
+        if (left-- == 0) {
+            targets = {
+                ash::Vector_2d(-draw(0.1, field_length/2),
+                        draw(-field_width/2, field_width/2)),
+                ash::Vector_2d(draw(0.1, field_length/2),
+                        draw(-field_width/2, field_width/2))};
+            left = 5 + rng()%46;
+        }
+        actions = targets;
+    }
+    return schedule;
+}
+
+template<class Environment>
+ash::Basic_vector_2d<typename Environment::Scalar> convert(
+        const ash::Vector_2d& v) {
+    typedef typename Environment::Scalar Scalar;
+    return ash::Basic_vector_2d<Scalar>(Scalar(v.x), Scalar(v.y));
+}
+
+// Plays the schedule and chains the state hashes of every tick.
+template<class Environment>
+std::uint64_t play(const std::vector<std::array<ash::Vector_2d,2>>& schedule,
+        double& rate, size_t& goals) {
+    Environment env;
+    std::vector<typename Environment::Action> actions;
+    for (const auto& tick : schedule) {
+        actions.push_back(convert<Environment>(tick[0]));
+        actions.push_back(convert<Environment>(tick[1]));
+    }
+    size_t sender = 0;
+    std::uint64_t chain = 0;
+    goals = 0;
+    auto start = Clock::now();
+    for (size_t t = 0; t < schedule.size(); ++t) {
+        if (env.step(actions[2*t], actions[2*t + 1]) != -1) {
+            ++goals;
+            sender = 1 - sender;
+            env.reset(sender);
+        }
+        chain = (chain ^ env.get_state_hash())*1099511628211ull;
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    rate = schedule.size()/elapsed.count();
+    return chain;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t ticks = argc > 1? std::stoul(argv[1]) : 200000;
+    auto schedule = make_schedule(ticks);
+
+    double double_rate, fixed_rate;
+    size_t double_goals, fixed_goals;
+    auto double_hash = play<ash::Environment>(schedule, double_rate,
+            double_goals);
+    auto fixed_hash = play<ash::Fixed_environment>(schedule, fixed_rate,
+            fixed_goals);
+    std::cout << ticks << " ticks" << std::endl << std::fixed
+              << std::setprecision(0)
+              << "double: " << double_rate << " step/s, " << double_goals
+              << " goals, state hash " << std::hex << double_hash
+              << std::dec << std::endl
+              << "fixed:  " << fixed_rate << " step/s, " << fixed_goals
+              << " goals" << std::endl
+              << "speedup: " << std::setprecision(2)
+              << fixed_rate/double_rate << std::endl;
+    // the fixed point hash is the same in every build
+    std::cout << "fixed point hash: " << std::hex << std::setw(16)
+              << std::setfill('0') << fixed_hash << std::endl;
+}
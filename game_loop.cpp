@@ -1,4 +1,5 @@
 #include "game_loop.hpp"
+#include "packets.hpp"
 
 #include <cassert>
 #include <iomanip>
@@ -21,72 +22,6 @@ sf::Packet& operator>>(sf::Packet& packet, Packet_type& type) {
     return packet;
 }
 
-sf::Packet& operator<<(sf::Packet& packet, const ash::Vector_2d& v) {
-  return packet << v.x << v.y;
-}
-
-sf::Packet& operator>>(sf::Packet& packet, ash::Vector_2d& v) {
-  return packet >> v.x >> v.y;
-}
-
-
-sf::Packet& operator<<(
-      sf::Packet& packet,
-      const ash::Environment::State::BodyStatus& status) {
-  return packet << status.position << status.velocity;
-}
-
-sf::Packet& operator>>(
-      sf::Packet& packet,
-      ash::Environment::State::BodyStatus& status) {
-  return packet >> status.position >> status.velocity;
-}
-
-sf::Packet& operator<<(
-      sf::Packet& packet,
-      const ash::Environment::State& state) {
-  return packet << state.mallets[0] << state.mallets[1]
-                << state.puck;
-}
-
-sf::Packet& operator>>(
-      sf::Packet& packet,
-      ash::Environment::State& state) {
-  return packet >> state.mallets[0] >> state.mallets[1]
-                >> state.puck;
-}
-
-
-sf::Packet& operator<<(
-      sf::Packet& packet,
-      const ash::Game_state& state) {
-  packet << state.environment.get_state()
-         << state.accumulator
-         << sf::Int32(state.score[0]) << sf::Int32(state.score[1])
-         << sf::Int32(state.sender)
-         << sf::Int32(state.new_game);
-  return packet;
-}
-
-sf::Packet& operator>>(
-      sf::Packet& packet,
-      ash::Game_state& state) {
-  using namespace ash::parameters;
-  ash::Environment::State env_state;
-  sf::Int32 score_0, score_1, sender, new_game;
-  packet >> env_state
-         >> state.accumulator
-         >> score_0 >> score_1
-         >> sender
-         >> new_game;
-  state.environment.set_state(env_state);
-  state.score[0] = score_0;
-  state.score[1] = score_1;
-  state.sender = sender;
-  state.new_game = new_game;
-  return packet;
-}
-
 void send_packet(sf::TcpSocket& socket, sf::Packet& packet,
         sf::Time timeout) {
     sf::Socket::Status status;
@@ -537,8 +472,29 @@ ash::Vector_2d ash::Remote_player::acquire_input() {
     return input;
 }
 
-ash::Server_loop::Server_loop(int local_player, unsigned short port) :
-    local_player(local_player), port(port)
+ash::Planner_player::Planner_player(int index, int iterations) :
+    Player(index), planner(index, iterations)
+{
+}
+
+void ash::Planner_player::report_state(const Game_state& state) {
+    this->state = state.environment.get_state();
+    if (state.new_game) {
+        plan = initial_plan(this->state);
+    }
+}
+
+ash::Vector_2d ash::Planner_player::acquire_input() {
+    plan = planner.improve(state, plan);
+    auto target = plan[0];
+    plan = shift_plan(plan);
+    return target;
+}
+
+ash::Server_loop::Server_loop(int local_player, unsigned short port,
+        bool computer_opponent) :
+    local_player(local_player), port(port),
+    computer_opponent(computer_opponent), history(history_capacity)
 {
 
 }
@@ -561,10 +517,16 @@ void ash::Server_loop::setup() {
     else {
         int remote = 1 - local_player;
         players[local_player].reset(new Local_player(local_player, this));
-        std::cout << "Waiting for player " << remote << "..." << std::endl;
-        players[remote].reset(
-                new Remote_player(remote, listener));
-        std::cout << "Player " << remote << " connected" << std::endl;
+        if (computer_opponent) {
+            players[remote].reset(new Planner_player(remote));
+        }
+        else {
+            std::cout << "Waiting for player " << remote << "..."
+                      << std::endl;
+            players[remote].reset(
+                    new Remote_player(remote, listener));
+            std::cout << "Player " << remote << " connected" << std::endl;
+        }
     }
     start_new_game();
     report_to_players();
@@ -573,12 +535,11 @@ void ash::Server_loop::setup() {
 void ash::Server_loop::update() {
     game_state.accumulator += clk.restart().asSeconds();
     while (game_state.accumulator > parameters::dt) {
-        auto input1 = players[0]->acquire_input();
-        auto input2 = players[1]->acquire_input();
-        int winner = game_state.environment.step(input1, input2);
-        if (winner != -1) {
-            ++game_state.score[winner];
-            start_new_game(1 - game_state.sender);
+        State_history::Input_pair inputs = {players[0]->acquire_input(),
+            players[1]->acquire_input()};
+        history.record(game_state, inputs);
+        if (play_tick(game_state, inputs[0], inputs[1]) != -1) {
+            wait_for_serve();
         }
         else {
             game_state.new_game = false;
@@ -588,9 +549,35 @@ void ash::Server_loop::update() {
     }
 }
 
+bool ash::Server_loop::correct_input(std::uint64_t tick, int player,
+        const Vector_2d& input) {
+    if (!history.contains(tick)) {
+        return false;
+    }
+    int score_before = game_state.score[0] + game_state.score[1];
+    history.set_input(tick, player, input);
+    int goals = history.resimulate(tick, game_state);
+    // the goals the same ticks had scored the first time
+    int score_after = game_state.score[0] + game_state.score[1];
+    int goals_before = score_before - (score_after - goals);
+    if (goals > goals_before) {
+        // the table has been reset for a serve the players have not seen
+        wait_for_serve();
+    }
+    else if (goals < goals_before) {
+        // the goal the serve was waiting for did not happen
+        game_state.new_game = false;
+    }
+    return true;
+}
+
 void ash::Server_loop::start_new_game(int sender) {
     game_state.sender = sender;
     game_state.environment.reset(sender);
+    wait_for_serve();
+}
+
+void ash::Server_loop::wait_for_serve() {
     game_state.new_game = true;
     game_state.accumulator = 0;
     clk.restart();
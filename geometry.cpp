@@ -1,12 +1,140 @@
 #include "geometry.hpp"
+#include "fixed_point.hpp"
+#include "dual.hpp"
 
-bool ash::AABB::intersects(const AABB& other) const {
-    return x_max > other.x_min && other.x_max > x_min &&
-           y_max > other.y_min && other.y_max > y_min;
-}
+#include <algorithm>
 
-bool ash::AABB::contains(const Vector_2d& point) const {
+template<class Scalar>
+bool ash::Basic_aabb<Scalar>::contains(
+        const Basic_vector_2d<Scalar>& point) const {
     return x_min < point.x && point.x < x_max &&
            y_min < point.y && point.y < y_max;
 }
 
+
+template<class Scalar>
+std::optional<ash::Basic_impact<Scalar>> ash::sweep_disk(
+        const Basic_vector_2d<Scalar>& position, Scalar radius,
+        const Basic_vector_2d<Scalar>& displacement,
+        const Basic_aabb<Scalar>& box) {
+    typedef Basic_vector_2d<Scalar> Vector_2d;
+    // ray against the box grown by the radius (slab test)
+    Scalar t_enter = -std::numeric_limits<Scalar>::infinity();
+    Scalar t_exit = std::numeric_limits<Scalar>::infinity();
+    Vector_2d normal;
+    const Scalar p[] = {position.x, position.y};
+    const Scalar d[] = {displacement.x, displacement.y};
+    const Scalar lo[] = {box.x_min - radius, box.y_min - radius};
+    const Scalar hi[] = {box.x_max + radius, box.y_max + radius};
+    for (size_t axis = 0; axis < 2; ++axis) {
+        if (d[axis] == 0) {
+            if (p[axis] <= lo[axis] || p[axis] >= hi[axis]) {
+                return {};
+            }
+            continue;
+        }
+        Scalar t_lo = (lo[axis] - p[axis])/d[axis];
+        Scalar t_hi = (hi[axis] - p[axis])/d[axis];
+        Scalar sign = -1;
+        if (t_lo > t_hi) {
+            std::swap(t_lo, t_hi);
+            sign = 1;
+        }
+        if (t_lo > t_enter) {
+            t_enter = t_lo;
+            normal = axis == 0? Vector_2d(sign, 0) : Vector_2d(0, sign);
+        }
+        t_exit = std::min(t_exit, t_hi);
+    }
+    if (t_exit <= 0 || t_enter > 1 || t_enter >= t_exit) {
+        return {};
+    }
+
+    // near the corners the grown box is rounded, so the disk may still be
+    // clear of the box even if it starts inside the grown box
+    auto contact = position + std::max(t_enter, Scalar(0))*displacement;
+    bool outside_x = contact.x < box.x_min || contact.x > box.x_max;
+    bool outside_y = contact.y < box.y_min || contact.y > box.y_max;
+    if (outside_x && outside_y) {
+        Vector_2d corner(contact.x < box.x_min? box.x_min : box.x_max,
+                contact.y < box.y_min? box.y_min : box.y_max);
+        return sweep_disk(position - corner, radius, displacement);
+    }
+    if (t_enter < 0) {
+        // already overlapping: stop it from going any deeper through the
+        // closest face
+        Scalar depth[] = {
+            position.x - lo[0], hi[0] - position.x,
+            position.y - lo[1], hi[1] - position.y};
+        const Vector_2d normals[] = {
+            Vector_2d(-1, 0), Vector_2d(1, 0),
+            Vector_2d(0, -1), Vector_2d(0, 1)};
+        size_t face = std::min_element(depth, depth + 4) - depth;
+        if (normals[face].dot(displacement) >= 0) {
+            return {};
+        }
+        return Basic_impact<Scalar>{0, normals[face]};
+    }
+    return Basic_impact<Scalar>{t_enter, normal};
+}
+
+template<class Scalar>
+std::optional<ash::Basic_impact<Scalar>> ash::sweep_disk(
+        const Basic_vector_2d<Scalar>& relative_position, Scalar radius,
+        const Basic_vector_2d<Scalar>& relative_displacement) {
+    typedef Basic_vector_2d<Scalar> Vector_2d;
+    // smallest t such that |p + t*d| = radius
+    Scalar a = relative_displacement.norm_sq();
+    Scalar b = relative_position.dot(relative_displacement);
+    Scalar c = relative_position.norm_sq() - radius*radius;
+    if (b >= 0) {
+        // moving apart
+        return {};
+    }
+    if (c < 0) {
+        // already overlapping and getting closer
+        Scalar distance = relative_position.norm();
+        return Basic_impact<Scalar>{0, distance == 0? Vector_2d(1, 0) :
+            relative_position/distance};
+    }
+    Scalar discriminant = b*b - a*c;
+    // a can only be zero in fixed point, where a displacement too short to
+    // square is no displacement at all
+    if (discriminant < 0 || a == 0) {
+        return {};
+    }
+    using std::sqrt;
+    Scalar t = (-b - sqrt(discriminant))/a;
+    if (t > 1) {
+        return {};
+    }
+    return Basic_impact<Scalar>{t,
+        (relative_position + t*relative_displacement)/radius};
+}
+
+template struct ash::Basic_aabb<double>;
+template struct ash::Basic_aabb<float>;
+template struct ash::Basic_aabb<ash::Fixed>;
+template struct ash::Basic_aabb<ash::Dual_scalar>;
+
+template std::optional<ash::Impact> ash::sweep_disk(const Vector_2d&, double,
+        const Vector_2d&, const AABB&);
+template std::optional<ash::Basic_impact<float>> ash::sweep_disk(
+        const Vector_2f&, float, const Vector_2f&, const Basic_aabb<float>&);
+
+template std::optional<ash::Impact> ash::sweep_disk(const Vector_2d&, double,
+        const Vector_2d&);
+template std::optional<ash::Basic_impact<float>> ash::sweep_disk(
+        const Vector_2f&, float, const Vector_2f&);
+
+template std::optional<ash::Basic_impact<ash::Fixed>> ash::sweep_disk(
+        const Basic_vector_2d<Fixed>&, Fixed, const Basic_vector_2d<Fixed>&,
+        const Basic_aabb<Fixed>&);
+template std::optional<ash::Basic_impact<ash::Fixed>> ash::sweep_disk(
+        const Basic_vector_2d<Fixed>&, Fixed, const Basic_vector_2d<Fixed>&);
+template std::optional<ash::Basic_impact<ash::Dual_scalar>> ash::sweep_disk(
+        const Basic_vector_2d<Dual_scalar>&, Dual_scalar,
+        const Basic_vector_2d<Dual_scalar>&, const Basic_aabb<Dual_scalar>&);
+template std::optional<ash::Basic_impact<ash::Dual_scalar>> ash::sweep_disk(
+        const Basic_vector_2d<Dual_scalar>&, Dual_scalar,
+        const Basic_vector_2d<Dual_scalar>&);
@@ -0,0 +1,135 @@
+#include "benchmark_support.hpp"
+#include "state_history.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+
+namespace {
+
+typedef ash::benchmark::Clock Clock;
+typedef ash::State_history::Input_pair Input_pair;
+typedef ash::Environment::Action Action;
+
+bool same(const ash::Match& a, const ash::Match& b) {
+    return a.environment.get_state_hash() == b.environment.get_state_hash()
+        && a.score == b.score && a.sender == b.sender;
+}
+
+ash::Match new_match() {
+    ash::Match match;
+    match.score = {0, 0};
+    match.sender = 0;
+    match.environment.reset(0);
+    return match;
+}
+
+// The server gets the input of the second player delay ticks late. Until
+// then it plays the tick with the last input it has, and when the input
+// arrives the tick is corrected. After every tick the server must agree
+// with a match that always had the right inputs, except for the ticks
+// still waiting for theirs. Returns the number of ticks where it does not.
+size_t check_late_inputs(const std::vector<Input_pair>& inputs,
+        size_t delay) {
+    ash::State_history history(50);
+    auto server = new_match();
+    auto reference = new_match();
+    std::vector<ash::Match> reference_states;
+    size_t mismatches = 0;
+    for (size_t t = 0; t < inputs.size(); ++t) {
+        reference_states.push_back(reference);
+        ash::play_tick(reference, inputs[t][0], inputs[t][1]);
+        // the guess: the last input received
+        Input_pair guess = {inputs[t][0],
+            t >= delay? inputs[t - delay][1] : Action()};
+        history.record(server, guess);
+        ash::play_tick(server, guess[0], guess[1]);
+        if (t >= delay) {
+            history.set_input(t - delay, 1, inputs[t - delay][1]);
+            history.resimulate(t - delay, server);
+            // the tick just corrected is now right
+            ash::Match check = server;
+            history.rewind(t - delay + 1, check);
+            if (!same(check, reference_states[t - delay + 1])) {
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Replaying with the same inputs must land on the same state. Returns the
+// number of replays where it does not.
+size_t check_replay(const std::vector<Input_pair>& inputs, size_t ticks_back) {
+    ash::State_history history(50);
+    auto match = new_match();
+    size_t mismatches = 0;
+    for (size_t t = 0; t < inputs.size(); ++t) {
+        history.record(match, inputs[t]);
+        ash::play_tick(match, inputs[t][0], inputs[t][1]);
+        if (t >= ticks_back) {
+            auto before = match;
+            history.resimulate(history.get_end() - ticks_back, match);
+            if (!same(before, match)) {
+                ++mismatches;
+            }
+        }
+    }
+    return mismatches;
+}
+
+// average time to rewind ticks_back ticks and play them again
+double measure_resimulation(const std::vector<Input_pair>& inputs,
+        size_t ticks_back) {
+    ash::State_history history(50);
+    auto match = new_match();
+    size_t count = 0;
+    std::chrono::duration<double> elapsed(0);
+    for (size_t t = 0; t < inputs.size(); ++t) {
+        history.record(match, inputs[t]);
+        ash::play_tick(match, inputs[t][0], inputs[t][1]);
+        if (t >= ticks_back) {
+            auto start = Clock::now();
+            history.resimulate(history.get_end() - ticks_back, match);
+            elapsed += Clock::now() - start;
+            ++count;
+        }
+    }
+    return elapsed.count()/count;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t ticks = argc > 1? std::stoul(argv[1]) : 20000;
+    auto inputs = ash::benchmark::make_schedule(ticks);
+
+    size_t total_mismatches = 0;
+    std::cout << ticks << " ticks, a history of 50 ticks" << std::endl;
+    for (size_t delay : {1, 5, 20}) {
+        size_t mismatches = check_late_inputs(inputs, delay);
+        total_mismatches += mismatches;
+        std::cout << "inputs " << std::setw(2) << delay << " ticks late: "
+                  << mismatches << " mismatches with the reference match"
+                  << std::endl;
+    }
+    std::cout << std::setw(10) << "rewind"
+              << std::setw(12) << "mismatches"
+              << std::setw(14) << "us/replay"
+              << std::setw(14) << "of a tick" << std::endl;
+    for (size_t ticks_back : {1, 10, 20, 50}) {
+        size_t mismatches = check_replay(inputs, ticks_back);
+        total_mismatches += mismatches;
+        double seconds = measure_resimulation(inputs, ticks_back);
+        std::cout << std::setw(10) << ticks_back
+                  << std::setw(12) << mismatches
+                  << std::fixed << std::setprecision(2)
+                  << std::setw(14) << seconds*1e6
+                  << std::setw(13) << 100*seconds/ash::parameters::dt << '%'
+                  << std::endl;
+    }
+    return total_mismatches == 0? 0 : 1;
+}
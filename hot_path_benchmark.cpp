@@ -0,0 +1,358 @@
+#include "benchmark_support.hpp"
+#include "packets.hpp"
+#include "physics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+
+// Timings of the hot paths of the physics and of the network code, for
+// tracking over time: make bench writes them to bench.json.
+//
+//   hot_path_benchmark [--json FILE] [--filter TEXT] [--time SECONDS]
+//
+// Every benchmark is warmed up, then timed in samples of a batch of calls
+// sized so that a sample takes about sample_time, until its time is up.
+// The statistics are over the samples, in ns per call.
+
+
+namespace {
+
+typedef ash::benchmark::Clock Clock;
+typedef ash::Environment::State State;
+typedef ash::Environment::Action Action;
+
+constexpr double warm_up_time = 0.05;
+constexpr double sample_time = 20e-6;
+constexpr size_t max_samples = 5000;
+
+// keeps the compiler from dropping a result nobody reads
+template<class T>
+void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+struct Stats {
+    std::string name;
+    size_t samples;
+    size_t batch;
+    double median;
+    double p99;
+    double mean;
+    double variance;
+};
+
+// op(i) is called with i = 0, 1, 2... across batches, so that it can cycle
+// through its inputs.
+Stats run(const std::string& name, double time,
+        const std::function<void(size_t)>& op) {
+    size_t i = 0;
+    auto sample = [&](size_t batch) {
+        auto start = Clock::now();
+        for (size_t end = i + batch; i < end; ++i) {
+            op(i);
+        }
+        return ash::benchmark::seconds_since(start);
+    };
+
+    // the warm up, then the batch that takes about sample_time (the
+    // fastest of a few tries, as an interruption makes one look slow)
+    for (auto start = Clock::now();
+            ash::benchmark::seconds_since(start) < warm_up_time;) {
+        sample(1);
+    }
+    size_t batch = 1;
+    while (std::min({sample(batch), sample(batch), sample(batch)}) <
+            sample_time && batch < (size_t(1) << 30)) {
+        batch *= 2;
+    }
+
+    // at least one sample, whatever the time
+    std::vector<double> ns;
+    for (auto start = Clock::now(); ns.empty() ||
+            (ns.size() < max_samples &&
+             ash::benchmark::seconds_since(start) < time);) {
+        ns.push_back(sample(batch)/batch*1e9);
+    }
+
+    Stats stats;
+    stats.name = name;
+    stats.samples = ns.size();
+    stats.batch = batch;
+    stats.mean = 0;
+    for (double x : ns) {
+        stats.mean += x/ns.size();
+    }
+    stats.variance = 0;
+    for (double x : ns) {
+        stats.variance += (x - stats.mean)*(x - stats.mean)/
+            std::max<size_t>(ns.size() - 1, 1);
+    }
+    stats.median = ash::benchmark::percentile(ns, 0.5);
+    stats.p99 = ash::benchmark::percentile(ns, 0.99);
+    return stats;
+}
+
+// A match that goes on for as long as it is stepped.
+struct Match_driver {
+    explicit Match_driver(ash::Environment env) :
+        env(env), schedule(ash::benchmark::make_schedule(4096)), sender(0) {
+    }
+
+    void step(size_t i) {
+        const auto& actions = schedule[i % schedule.size()];
+        if (env.step(actions[0], actions[1]) != -1) {
+            sender = 1 - sender;
+            env.reset(sender);
+        }
+    }
+
+    ash::Environment env;
+    std::vector<ash::benchmark::Action_pair> schedule;
+    size_t sender;
+};
+
+// Bodies at random around the rink, about half of the pairs in contact.
+template<class Body>
+std::vector<Body> random_bodies(size_t count, unsigned seed,
+        const Body& prototype) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> position(-0.1, 0.1);
+    std::uniform_real_distribution<double> velocity(-2, 2);
+    std::vector<Body> out(count, prototype);
+    for (auto& body : out) {
+        body.set_position(ash::Vector_2d(position(rng), position(rng)));
+        body.set_velocity(ash::Vector_2d(velocity(rng), velocity(rng)));
+    }
+    return out;
+}
+
+void print(const Stats& stats) {
+    std::cout << std::left << std::setw(34) << stats.name << std::right
+              << std::fixed << std::setprecision(1)
+              << std::setw(10) << stats.median
+              << std::setw(10) << stats.p99
+              << std::setw(10) << stats.mean
+              << std::setprecision(3)
+              << std::setw(12) << stats.variance
+              << std::setw(9) << stats.samples
+              << std::setw(9) << stats.batch
+              << std::defaultfloat << std::endl;
+}
+
+void write_json(const std::vector<Stats>& results, std::ostream& out) {
+    auto seconds = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    out << std::setprecision(6);
+    out << "{\n"
+        << "  \"timestamp\": " << seconds << ",\n"
+        << "  \"compiler\": \"" << __VERSION__ << "\",\n"
+        << "  \"unit\": \"ns\",\n"
+        << "  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& stats = results[i];
+        out << (i == 0? "\n" : ",\n")
+            << "    {\"name\": \"" << stats.name << "\""
+            << ", \"samples\": " << stats.samples
+            << ", \"iterations_per_sample\": " << stats.batch
+            << ", \"median\": " << stats.median
+            << ", \"p99\": " << stats.p99
+            << ", \"mean\": " << stats.mean
+            << ", \"variance\": " << stats.variance
+            << ", \"stddev\": " << std::sqrt(stats.variance) << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    std::string json_path;
+    std::string filter;
+    double time = 0.3;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        }
+        else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        }
+        else if (arg == "--time" && i + 1 < argc) {
+            time = std::stod(argv[++i]);
+        }
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [--json FILE] [--filter TEXT] [--time SECONDS]\n";
+            return 2;
+        }
+    }
+
+    std::vector<Stats> results;
+    auto bench = [&](const std::string& name,
+            const std::function<void(size_t)>& op) {
+        if (name.find(filter) == std::string::npos) {
+            return;
+        }
+        results.push_back(run(name, time, op));
+        print(results.back());
+    };
+
+    std::cout << std::left << std::setw(34) << "ns per call" << std::right
+              << std::setw(10) << "median"
+              << std::setw(10) << "p99"
+              << std::setw(10) << "mean"
+              << std::setw(12) << "variance"
+              << std::setw(9) << "samples"
+              << std::setw(9) << "batch" << std::endl;
+
+    // Environment
+    {
+        Match_driver match{ash::Environment()};
+        bench("environment/step", [&](size_t i) {
+                match.step(i);
+            });
+    }
+    {
+        ash::Environment env;
+        env.set_fast_path(false);
+        Match_driver match(env);
+        bench("environment/step_no_fast_path", [&](size_t i) {
+                match.step(i);
+            });
+    }
+    {
+        // substep is private: a step of a single substep, through the
+        // narrow phase every time
+        ash::Environment env;
+        env.set_fixed_substeps(1);
+        env.set_fast_path(false);
+        Match_driver match(env);
+        bench("environment/substep", [&](size_t i) {
+                match.step(i);
+            });
+    }
+
+    // narrow phase, on 256 pairs
+    {
+        constexpr size_t count = 256;
+        using namespace ::ash::parameters;
+        auto disks = random_bodies(count, 1,
+                ash::Disk(puck_radius, puck_mass));
+        auto others = random_bodies(count, 2,
+                ash::Disk(mallet_radius, mallet_mass));
+        auto boxes = random_bodies(count, 3,
+                ash::Box(ash::Vector_2d(0.1, 0.05), ash::inf));
+        auto other_boxes = random_bodies(count, 4,
+                ash::Box(ash::Vector_2d(0.05, 0.1), ash::inf));
+        bench("collides/box_box", [&](size_t i) {
+                keep(ash::collides(boxes[i % count],
+                            other_boxes[i % count]));
+            });
+        bench("collides/box_disk", [&](size_t i) {
+                keep(ash::collides(boxes[i % count], disks[i % count]));
+            });
+        bench("collides/disk_box", [&](size_t i) {
+                keep(ash::collides(disks[i % count], boxes[i % count]));
+            });
+        bench("collides/disk_disk", [&](size_t i) {
+                keep(ash::collides(disks[i % count], others[i % count]));
+            });
+        bench("collides/dispatched", [&](size_t i) {
+                // a disk against a box or a disk, through the type tags
+                ash::Body& a = disks[i % count];
+                ash::Body& b = i % 2 == 0?
+                    static_cast<ash::Body&>(others[i % count]) :
+                    static_cast<ash::Body&>(boxes[i % count]);
+                keep(ash::collides(a, b));
+            });
+
+        // contacts between disks, each resolved from its velocities as
+        // they were before
+        std::vector<ash::Collision> collisions;
+        std::vector<std::array<ash::Vector_2d,2>> velocities;
+        for (size_t i = 0; i < count; ++i) {
+            if (auto collision = ash::collides(disks[i], others[i])) {
+                collisions.push_back(*collision);
+                velocities.push_back({disks[i].get_velocity(),
+                        others[i].get_velocity()});
+            }
+        }
+        bench("resolve_collision/disk_disk", [&](size_t i) {
+                auto& collision = collisions[i % collisions.size()];
+                const auto& before = velocities[i % collisions.size()];
+                collision.a->set_velocity(before[0]);
+                collision.b->set_velocity(before[1]);
+                ash::resolve_collision(collision, 0.9);
+                keep(collision.b->get_velocity());
+            });
+    }
+
+    // state
+    {
+        Match_driver match{ash::Environment()};
+        std::vector<State> states;
+        for (size_t i = 0; i < 256; ++i) {
+            match.step(i);
+            states.push_back(match.env.get_state());
+        }
+        bench("state/get_state", [&](size_t) {
+                keep(match.env.get_state());
+            });
+        bench("state/set_state", [&](size_t i) {
+                match.env.set_state(states[i % states.size()]);
+                keep(match.env);
+            });
+    }
+
+    // what the server sends the clients every tick
+    {
+        ash::Game_state game_state;
+        game_state.accumulator = 0.004;
+        game_state.new_game = false;
+        game_state.score = {3, 5};
+        game_state.sender = 1;
+        Match_driver match{ash::Environment()};
+        for (size_t i = 0; i < 100; ++i) {
+            match.step(i);
+        }
+        game_state.environment = match.env;
+        sf::Packet packet;
+        bench("packet/write_game_state", [&](size_t) {
+                packet.clear();
+                packet << game_state;
+                keep(packet);
+            });
+        sf::Packet written;
+        written << game_state;
+        ash::Game_state read_back;
+        bench("packet/read_game_state", [&](size_t) {
+                // reading consumes the packet: refill it first, which
+                // reuses its buffer
+                packet.clear();
+                packet.append(written.getData(), written.getDataSize());
+                packet >> read_back;
+                keep(read_back);
+            });
+    }
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        write_json(results, out);
+        if (!out) {
+            std::cerr << "cannot write " << json_path << std::endl;
+            return 1;
+        }
+        std::cout << "wrote " << json_path << std::endl;
+    }
+    return 0;
+}
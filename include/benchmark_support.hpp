@@ -0,0 +1,136 @@
+#pragma once
+
+#include "physics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+
+// What the benchmark programs have in common: the clock, the matches they
+// play and the statistics of their timings.
+namespace ash {
+
+namespace benchmark {
+
+typedef std::chrono::steady_clock Clock;
+typedef std::array<Vector_2d,2> Action_pair;
+
+inline double seconds_since(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template<class T>
+bool same_bits(const T& a, const T& b) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+// Value below which a fraction p of the values lie (0 if there are none).
+inline double percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0;
+    }
+    std::sort(values.begin(), values.end());
+    return values[std::min(values.size() - 1,
+            static_cast<size_t>(p*values.size()))];
+}
+
+// Mallets pick a random spot in their own half and stay there for 5 to 50
+// ticks. The schedule does not depend on the state, so that it can be
+// played as it is by any environment.
+inline std::vector<Action_pair> make_schedule(size_t ticks,
+        unsigned seed = 1) {
+    using namespace ::ash::parameters;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> x(0.1, field_length/2);
+    std::uniform_real_distribution<double> y(-field_width/2, field_width/2);
+    std::uniform_int_distribution<int> hold(5, 50);
+    std::vector<Action_pair> schedule(ticks);
+    Action_pair targets;
+    int left = 0;
+    for (auto& actions : schedule) {
+        if (left-- == 0) {
+            targets = {Vector_2d(-x(rng), y(rng)), Vector_2d(x(rng), y(rng))};
+            left = hold(rng);
+        }
+        actions = targets;
+    }
+    return schedule;
+}
+
+// Mallets pick a random spot in their own half and stay there for a while,
+// now and then going after the puck, so that a match has both quiet ticks
+// and plenty of contacts.
+class Random_player {
+    public:
+        Random_player(size_t side, unsigned seed) :
+            side(side), rng(seed), target(0, 0), hold(0) {
+        }
+
+        Vector_2d get_action(const Environment::State& state) {
+            using namespace ::ash::parameters;
+            if (hold > 0) {
+                --hold;
+                return target;
+            }
+            std::uniform_real_distribution<double> x(0.1, field_length/2);
+            std::uniform_real_distribution<double> y(
+                    -field_width/2, field_width/2);
+            std::uniform_int_distribution<int> ticks(5, 50);
+            std::bernoulli_distribution chase(0.3);
+            double sign = side == 0? -1 : 1;
+            target = chase(rng)? state.puck.position :
+                Vector_2d(sign*x(rng), y(rng));
+            hold = ticks(rng);
+            return target;
+        }
+
+    private:
+        size_t side;
+        std::mt19937 rng;
+        Vector_2d target;
+        int hold;
+};
+
+// Steps env through the schedule, a new serve after every goal, and returns
+// the ticks per second.
+template<class Environment>
+double steps_per_second(Environment env,
+        const std::vector<Action_pair>& schedule) {
+    typedef typename Environment::Action Action;
+    size_t sender = 0;
+    auto start = Clock::now();
+    for (const auto& actions : schedule) {
+        if (env.step(Action(actions[0]), Action(actions[1])) != -1) {
+            sender = 1 - sender;
+            env.reset(sender);
+        }
+    }
+    return schedule.size()/seconds_since(start);
+}
+
+// The same, for ticks of a match between two Random_players.
+inline double random_steps_per_second(Environment env, size_t ticks) {
+    Random_player players[] = {Random_player(0, 1), Random_player(1, 2)};
+    size_t sender = 0;
+    auto start = Clock::now();
+    for (size_t t = 0; t < ticks; ++t) {
+        auto state = env.get_state();
+        auto a1 = players[0].get_action(state);
+        auto a2 = players[1].get_action(state);
+        if (env.step(a1, a2) != -1) {
+            sender = 1 - sender;
+            env.reset(sender);
+        }
+    }
+    return ticks/seconds_since(start);
+}
+
+}
+
+}
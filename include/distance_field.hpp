@@ -0,0 +1,88 @@
+#pragma once
+
+#include "geometry.hpp"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace ash {
+
+// Signed distance to a fixed set of boxes, sampled on a regular grid and
+// interpolated bilinearly. The distance is negative inside the boxes and the
+// normal points away from them. Where a single face is the closest feature
+// the distance is linear, so the interpolation is exact along the walls.
+// The samples are stored in single precision whatever the scalar type.
+template<class Scalar>
+class Basic_distance_field {
+    public:
+        typedef Basic_vector_2d<Scalar> Vector_2d;
+        typedef Basic_aabb<Scalar> AABB;
+
+        struct Sample {
+            Scalar distance;
+            Vector_2d normal;
+        };
+
+        Basic_distance_field(const std::vector<AABB>& boxes,
+                const AABB& bounds, Scalar resolution);
+
+        bool covers(const Vector_2d& point) const {
+            return bounds.x_min <= point.x && point.x < bounds.x_max &&
+                   bounds.y_min <= point.y && point.y < bounds.y_max;
+        }
+
+        // point must be covered by the field
+        Scalar distance(const Vector_2d& point) const {
+            Cell cell = locate(point);
+            return (cell.d[0]*(1 - cell.fx) + cell.d[1]*cell.fx)*(1 - cell.fy) +
+                   (cell.d[2]*(1 - cell.fx) + cell.d[3]*cell.fx)*cell.fy;
+        }
+
+        // point must be covered by the field
+        Sample lookup(const Vector_2d& point) const;
+
+        size_t get_columns() const {
+            return columns;
+        }
+
+        size_t get_rows() const {
+            return rows;
+        }
+
+    private:
+        // the four samples around a point and its position between them
+        struct Cell {
+            Scalar d[4];
+            Scalar fx;
+            Scalar fy;
+        };
+
+        Cell locate(const Vector_2d& point) const {
+            Scalar u = (point.x - bounds.x_min)*inv_resolution;
+            Scalar v = (point.y - bounds.y_min)*inv_resolution;
+            // (u and v are not negative, through int they convert from
+            // fixed point too)
+            size_t j = std::min<size_t>(static_cast<int>(u), columns - 2);
+            size_t i = std::min<size_t>(static_cast<int>(v), rows - 2);
+            const float* row = &distances[i*columns + j];
+            return Cell{{row[0], row[1], row[columns], row[columns + 1]},
+                u - j, v - i};
+        }
+
+        AABB bounds;
+        Scalar resolution;
+        Scalar inv_resolution;
+        size_t columns;
+        size_t rows;
+        // rows*columns samples, row major
+        std::vector<float> distances;
+};
+
+typedef Basic_distance_field<double> Distance_field;
+
+template<class Scalar>
+Scalar signed_distance(const Basic_aabb<Scalar>& box,
+        const Basic_vector_2d<Scalar>& point);
+
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <ostream>
+
+
+namespace ash {
+
+// Forward mode automatic differentiation: a value, and its derivatives with
+// respect to N inputs. The physics is templated on the scalar type, so a
+// Basic_environment<Dual<N>> steps like any other and also carries the
+// derivatives of its state with respect to whatever inputs were seeded with
+// variable(): the actions of the following ticks, the initial state, or a
+// mix of both.
+//
+// Comparisons only look at the values, so every branch of the contact code
+// (which side of a box, whether the puck is bouncing, whether a penetration
+// is worth correcting) differentiates the branch the values take. Where two
+// branches meet the derivative is the one of the branch taken, and sqrt has
+// a derivative of zero at zero (a coincident disk gets a fixed normal), so
+// the derivatives are always finite.
+template<size_t N>
+class Dual {
+    public:
+        typedef std::array<double,N> Gradient;
+
+        static constexpr size_t size = N;
+
+        // a constant: all its derivatives are zero
+        constexpr Dual(double value = 0) : value(value), gradient{} {}
+
+        constexpr Dual(double value, const Gradient& gradient) :
+            value(value), gradient(gradient) {}
+
+        // the i-th input, with a value of value
+        static constexpr Dual variable(double value, size_t i) {
+            Dual out(value);
+            out.gradient[i] = 1;
+            return out;
+        }
+
+        constexpr double get_value() const {
+            return value;
+        }
+
+        constexpr double get_derivative(size_t i) const {
+            return gradient[i];
+        }
+
+        constexpr const Gradient& get_gradient() const {
+            return gradient;
+        }
+
+        explicit constexpr operator double() const {
+            return value;
+        }
+
+        explicit constexpr operator float() const {
+            return static_cast<float>(value);
+        }
+
+        // rounds towards zero
+        explicit constexpr operator int() const {
+            return static_cast<int>(value);
+        }
+
+        constexpr Dual operator-() const {
+            return scaled(*this, -1, -value);
+        }
+
+        friend constexpr Dual operator+(const Dual& a, const Dual& b) {
+            Dual out(a.value + b.value);
+            for (size_t i = 0; i < N; ++i) {
+                out.gradient[i] = a.gradient[i] + b.gradient[i];
+            }
+            return out;
+        }
+
+        friend constexpr Dual operator-(const Dual& a, const Dual& b) {
+            Dual out(a.value - b.value);
+            for (size_t i = 0; i < N; ++i) {
+                out.gradient[i] = a.gradient[i] - b.gradient[i];
+            }
+            return out;
+        }
+
+        friend constexpr Dual operator*(const Dual& a, const Dual& b) {
+            Dual out(a.value*b.value);
+            for (size_t i = 0; i < N; ++i) {
+                out.gradient[i] = a.gradient[i]*b.value +
+                    a.value*b.gradient[i];
+            }
+            return out;
+        }
+
+        friend constexpr Dual operator/(const Dual& a, const Dual& b) {
+            Dual out(a.value/b.value);
+            for (size_t i = 0; i < N; ++i) {
+                out.gradient[i] = (a.gradient[i] -
+                        out.value*b.gradient[i])/b.value;
+            }
+            return out;
+        }
+
+        Dual& operator+=(const Dual& other) {
+            return *this = *this + other;
+        }
+
+        Dual& operator-=(const Dual& other) {
+            return *this = *this - other;
+        }
+
+        Dual& operator*=(const Dual& other) {
+            return *this = *this*other;
+        }
+
+        Dual& operator/=(const Dual& other) {
+            return *this = *this/other;
+        }
+
+        friend constexpr bool operator==(const Dual& a, const Dual& b) {
+            return a.value == b.value;
+        }
+
+        friend constexpr bool operator!=(const Dual& a, const Dual& b) {
+            return a.value != b.value;
+        }
+
+        friend constexpr bool operator<(const Dual& a, const Dual& b) {
+            return a.value < b.value;
+        }
+
+        friend constexpr bool operator>(const Dual& a, const Dual& b) {
+            return a.value > b.value;
+        }
+
+        friend constexpr bool operator<=(const Dual& a, const Dual& b) {
+            return a.value <= b.value;
+        }
+
+        friend constexpr bool operator>=(const Dual& a, const Dual& b) {
+            return a.value >= b.value;
+        }
+
+        // The generic physics code calls these unqualified, after a using
+        // declaration of the std version, so they are found by ADL.
+
+        friend constexpr Dual abs(const Dual& x) {
+            return x.value < 0? -x : x;
+        }
+
+        friend constexpr Dual fmin(const Dual& a, const Dual& b) {
+            return b < a? b : a;
+        }
+
+        // piecewise constant
+        friend constexpr Dual ceil(const Dual& x) {
+            using std::ceil;
+            return Dual(ceil(x.value));
+        }
+
+        friend Dual sqrt(const Dual& x) {
+            using std::sqrt;
+            double root = sqrt(x.value);
+            return scaled(x, root > 0? 1/(2*root) : 0, root);
+        }
+
+    private:
+        // value, and the derivatives of x times factor
+        static constexpr Dual scaled(const Dual& x, double factor,
+                double value) {
+            Dual out(value);
+            for (size_t i = 0; i < N; ++i) {
+                out.gradient[i] = factor*x.gradient[i];
+            }
+            return out;
+        }
+
+        double value;
+        Gradient gradient;
+};
+
+// What the physics is compiled for: enough inputs for the targets of a
+// mallet during 8 ticks (see Gradient_planner).
+typedef Dual<16> Dual_scalar;
+
+template<size_t N>
+std::ostream& operator<<(std::ostream& out, const Dual<N>& x) {
+    return out << x.get_value();
+}
+
+}
+
+
+namespace std {
+
+template<size_t N>
+struct numeric_limits<ash::Dual<N>> {
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_exact = false;
+    static constexpr bool has_infinity = true;
+
+    static constexpr ash::Dual<N> max() {
+        return numeric_limits<double>::max();
+    }
+
+    static constexpr ash::Dual<N> lowest() {
+        return numeric_limits<double>::lowest();
+    }
+
+    static constexpr ash::Dual<N> epsilon() {
+        return numeric_limits<double>::epsilon();
+    }
+
+    static constexpr ash::Dual<N> infinity() {
+        return numeric_limits<double>::infinity();
+    }
+};
+
+}
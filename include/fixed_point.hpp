@@ -0,0 +1,219 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <type_traits>
+
+
+namespace ash {
+
+// Signed Q32.32 fixed point number. Every operation is done on integers,
+// so results are the same whatever the compiler, the flags or the CPU,
+// which floating point cannot promise. The range (+-2^31) and resolution
+// (2^-32, about 2.3e-10) are plenty for a table a couple of metres long.
+//
+// Conversions from floating point round to nearest and saturate, and are
+// only meant for constants and inputs: a double converts to the same
+// fixed point number everywhere, even though the double itself may not be
+// computed the same everywhere.
+class Fixed {
+    public:
+        typedef std::int64_t Raw;
+
+        static constexpr int fraction_bits = 32;
+        static constexpr Raw one = Raw(1) << fraction_bits;
+
+        constexpr Fixed() : raw(0) {}
+
+        template<class Integer,
+            std::enable_if_t<std::is_integral_v<Integer>, int> = 0>
+        constexpr Fixed(Integer x) : raw(Raw(x)*one) {}
+
+        constexpr Fixed(double x) : raw(from_double(x)) {}
+
+        static constexpr Fixed from_raw(Raw raw) {
+            Fixed out;
+            out.raw = raw;
+            return out;
+        }
+
+        constexpr Raw get_raw() const {
+            return raw;
+        }
+
+        explicit constexpr operator double() const {
+            return static_cast<double>(raw)/one;
+        }
+
+        explicit constexpr operator float() const {
+            return static_cast<float>(static_cast<double>(*this));
+        }
+
+        // rounds towards zero
+        explicit constexpr operator int() const {
+            return static_cast<int>(raw/one);
+        }
+
+        constexpr Fixed operator-() const {
+            return from_raw(-raw);
+        }
+
+        friend constexpr Fixed operator+(Fixed a, Fixed b) {
+            return from_raw(a.raw + b.raw);
+        }
+
+        friend constexpr Fixed operator-(Fixed a, Fixed b) {
+            return from_raw(a.raw - b.raw);
+        }
+
+        // rounds to nearest
+        friend constexpr Fixed operator*(Fixed a, Fixed b) {
+            Wide product = Wide(a.raw)*b.raw;
+            return from_raw(static_cast<Raw>(
+                        (product + (Wide(1) << (fraction_bits - 1))) >>
+                        fraction_bits));
+        }
+
+        // rounds towards zero, and saturates (slab tests divide by tiny
+        // displacements), a division by zero included (0/0 is 0)
+        friend constexpr Fixed operator/(Fixed a, Fixed b) {
+            constexpr Raw max = std::numeric_limits<Raw>::max();
+            if (b.raw == 0) {
+                return from_raw(a.raw > 0? max : a.raw < 0? -max : 0);
+            }
+            Wide quotient = Wide(a.raw)*one/b.raw;
+            return from_raw(quotient > max? max :
+                    quotient < -max? -max : static_cast<Raw>(quotient));
+        }
+
+        Fixed& operator+=(Fixed other) {
+            return *this = *this + other;
+        }
+
+        Fixed& operator-=(Fixed other) {
+            return *this = *this - other;
+        }
+
+        Fixed& operator*=(Fixed other) {
+            return *this = *this*other;
+        }
+
+        Fixed& operator/=(Fixed other) {
+            return *this = *this/other;
+        }
+
+        friend constexpr bool operator==(Fixed a, Fixed b) {
+            return a.raw == b.raw;
+        }
+
+        friend constexpr bool operator!=(Fixed a, Fixed b) {
+            return a.raw != b.raw;
+        }
+
+        friend constexpr bool operator<(Fixed a, Fixed b) {
+            return a.raw < b.raw;
+        }
+
+        friend constexpr bool operator>(Fixed a, Fixed b) {
+            return a.raw > b.raw;
+        }
+
+        friend constexpr bool operator<=(Fixed a, Fixed b) {
+            return a.raw <= b.raw;
+        }
+
+        friend constexpr bool operator>=(Fixed a, Fixed b) {
+            return a.raw >= b.raw;
+        }
+
+        // The generic physics code calls these unqualified, after a using
+        // declaration of the std version, so they are found by ADL.
+
+        friend constexpr Fixed abs(Fixed x) {
+            return x.raw < 0? -x : x;
+        }
+
+        friend constexpr Fixed fmin(Fixed a, Fixed b) {
+            return b < a? b : a;
+        }
+
+        friend constexpr Fixed ceil(Fixed x) {
+            return from_raw(-((-x.raw) & ~(one - 1)));
+        }
+
+        // rounds down, exactly
+        friend Fixed sqrt(Fixed x) {
+            if (x.raw <= 0) {
+                return Fixed();
+            }
+            // sqrt(raw/2^32)*2^32 = sqrt(raw)*2^16; the floating point
+            // estimate is only a starting point for the integer fix up
+            UWide n = UWide(x.raw) << fraction_bits;
+            auto s = static_cast<std::uint64_t>(
+                    std::sqrt(static_cast<double>(x.raw))*(1 << 16));
+            while (UWide(s)*s > n) {
+                --s;
+            }
+            while (UWide(s + 1)*(s + 1) <= n) {
+                ++s;
+            }
+            return from_raw(static_cast<Raw>(s));
+        }
+
+    private:
+        __extension__ typedef __int128 Wide;
+        __extension__ typedef unsigned __int128 UWide;
+
+        static constexpr Raw from_double(double x) {
+            constexpr double limit = 2147483648.0;
+            if (!(x < limit)) {
+                return std::numeric_limits<Raw>::max();
+            }
+            if (!(x > -limit)) {
+                return -std::numeric_limits<Raw>::max();
+            }
+            double scaled = x*one;
+            return static_cast<Raw>(scaled < 0? scaled - 0.5 : scaled + 0.5);
+        }
+
+        Raw raw;
+};
+
+inline std::ostream& operator<<(std::ostream& out, Fixed x) {
+    return out << static_cast<double>(x);
+}
+
+}
+
+
+namespace std {
+
+// Fixed has no infinity: the largest number stands for it, so that walls
+// still get an inverse mass of exactly zero.
+template<>
+struct numeric_limits<ash::Fixed> {
+    static constexpr bool is_specialized = true;
+    static constexpr bool is_exact = true;
+    static constexpr bool has_infinity = false;
+
+    static constexpr ash::Fixed max() {
+        return ash::Fixed::from_raw(
+                std::numeric_limits<ash::Fixed::Raw>::max());
+    }
+
+    static constexpr ash::Fixed lowest() {
+        return -max();
+    }
+
+    static constexpr ash::Fixed epsilon() {
+        return ash::Fixed::from_raw(1);
+    }
+
+    static constexpr ash::Fixed infinity() {
+        return max();
+    }
+};
+
+}
@@ -1,17 +1,14 @@
+#pragma once
+
 #include <SFML/Graphics.hpp>
 #include <SFML/Network.hpp>
+#include "game_state.hpp"
 #include "physics.hpp"
+#include "planner.hpp"
+#include "state_history.hpp"
 
 namespace ash {
 
-struct Game_state {
-    Environment environment;
-    double accumulator;
-    std::array<int,2> score;
-    int sender;
-    bool new_game;
-};
-
 class Game_loop {
     public:
         Game_loop();
@@ -117,10 +114,40 @@ class Remote_player : public Player {
         sf::TcpSocket client;
 };
 
+// A computer opponent. Every tick it refines what is left of the plan of
+// the previous tick with a Gradient_planner, and heads for the first target.
+class Planner_player : public Player {
+    public:
+
+        explicit Planner_player(int index, int iterations = 5);
+
+        void report_state(const Game_state& state) override;
+
+        Vector_2d acquire_input() override;
+
+    private:
+        Gradient_planner planner;
+        Environment::State state;
+        Plan plan;
+};
+
 
 class Server_loop : public Game_loop {
     public:
-        Server_loop(int local_player, unsigned short port);
+        // with computer_opponent, the other player is a Planner_player
+        // instead of a remote one
+        Server_loop(int local_player, unsigned short port,
+                bool computer_opponent = false);
+
+        // An input for a tick that has already been played, because it
+        // arrived late or corrects the one used: the ticks since then are
+        // played again, and a goal the replay adds or takes away starts or
+        // cancels the wait for the serve. Returns false if the tick has
+        // left the history. Ticks are numbered as in State_history; the
+        // inputs of a Remote_player carry no tick number, so getting them
+        // here is up to the transport.
+        bool correct_input(std::uint64_t tick, int player,
+                const Vector_2d& input);
 
     protected:
 
@@ -130,14 +157,21 @@ class Server_loop : public Game_loop {
 
     private:
 
+        // a second of play
+        static constexpr size_t history_capacity = 50;
+
         void start_new_game(int sender = 0);
 
+        void wait_for_serve();
+
         void report_to_players();
 
         sf::Clock clk;
         std::array<Player::Ptr,2> players;
         int local_player;
         unsigned short port;
+        bool computer_opponent;
+        State_history history;
 };
 
 class Client_loop : public Game_loop {
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "state_history.hpp"
+
+
+namespace ash {
+
+// the match, and where the loop stands in real time
+struct Game_state : Match {
+    double accumulator;
+    bool new_game;
+};
+
+}
@@ -2,19 +2,56 @@
 
 #include "vector_maths.hpp"
 #include <limits>
+#include <optional>
 
 namespace ash {
 
-struct AABB {
-    double x_min;
-    double x_max;
-    double y_min;
-    double y_max;
+template<class Scalar_type>
+struct Basic_aabb {
+    typedef Scalar_type Scalar;
 
-    bool intersects(const AABB& other) const;
+    Scalar x_min;
+    Scalar x_max;
+    Scalar y_min;
+    Scalar y_max;
 
-    bool contains(const Vector_2d& point) const;
+    bool intersects(const Basic_aabb& other) const {
+        return x_max > other.x_min && other.x_max > x_min &&
+               y_max > other.y_min && other.y_max > y_min;
+    }
 
+    bool contains(const Basic_vector_2d<Scalar>& point) const;
+
+};
+
+typedef Basic_aabb<double> AABB;
+
+// First contact of a moving disk with an obstacle. time is the fraction of
+// the displacement travelled before the contact, and normal points from the
+// obstacle towards the disk.
+template<class Scalar>
+struct Basic_impact {
+    Scalar time;
+    Basic_vector_2d<Scalar> normal;
 };
 
+typedef Basic_impact<double> Impact;
+
+// Swept disk vs static box. A disk that already overlaps the box hits it at
+// time 0 if it moves deeper into it, and a disk moving away from the box
+// never hits it.
+template<class Scalar>
+std::optional<Basic_impact<Scalar>> sweep_disk(
+        const Basic_vector_2d<Scalar>& position, Scalar radius,
+        const Basic_vector_2d<Scalar>& displacement,
+        const Basic_aabb<Scalar>& box);
+
+// Swept disk vs disk, given the position and displacement of the first disk
+// relative to the second one, and the sum of their radii. Overlaps are
+// handled as for boxes.
+template<class Scalar>
+std::optional<Basic_impact<Scalar>> sweep_disk(
+        const Basic_vector_2d<Scalar>& relative_position, Scalar radius,
+        const Basic_vector_2d<Scalar>& relative_displacement);
+
 }
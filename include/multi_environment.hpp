@@ -0,0 +1,122 @@
+#pragma once
+
+#include "physics.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace ash {
+
+// A table with any number of mallets and pucks, for drills and stress
+// tests. The rink and the controller of the mallets are those of
+// Environment; mallets stay in the half they are put in, pucks bounce off
+// every other body, and a puck that enters a goal is taken off the table.
+// Two mallets bounce off each other as off a wall, and so do two pucks.
+//
+// Contacts between moving bodies go through a broadphase that only hands
+// the narrow phase the pairs whose bounding boxes overlap, so that a
+// substep costs about as much per body whatever the number of bodies.
+// Either broadphase gives the same pairs, and the pairs are resolved in the
+// same order, so the results do not depend on it.
+//
+// Only semi-implicit Euler with a fixed number of substeps and discrete
+// collision detection: none of the options of Environment.
+class Multi_environment {
+    public:
+        typedef Environment::Action Action;
+
+        enum class Broadphase {
+            // every pair of bodies, as a reference
+            brute_force,
+            // bodies sorted along x, kept sorted from substep to substep
+            sweep_and_prune
+        };
+
+        explicit Multi_environment(
+                const Parameter_set& parameters = default_parameters);
+
+        const Parameter_set& get_parameters() const {
+            return parameters;
+        }
+
+        const Rink& get_rink() const {
+            return *rink;
+        }
+
+        // Both return the index of the new body. Mallets are at rest and
+        // must be put clear of the centre line.
+        size_t add_mallet(const Vector_2d& position);
+
+        size_t add_puck(const Vector_2d& position,
+                const Vector_2d& velocity = Vector_2d(0, 0));
+
+        const std::vector<Disk>& get_mallets() const {
+            return mallets;
+        }
+
+        // pucks keep their order, less the ones that were scored
+        const std::vector<Disk>& get_pucks() const {
+            return pucks;
+        }
+
+        Broadphase get_broadphase() const {
+            return broadphase;
+        }
+
+        void set_broadphase(Broadphase broadphase) {
+            this->broadphase = broadphase;
+        }
+
+        // One target per mallet. Returns the goals scored during the step
+        // by each side (side 0 scores in the goal at +x).
+        std::array<int,2> step(const std::vector<Action>& actions);
+
+        // pairs of moving bodies handed to the narrow phase during the last
+        // step
+        size_t get_last_pair_tests() const {
+            return last_pair_tests;
+        }
+
+        // FNV-1a hash of the positions and velocities of every body
+        std::uint64_t get_state_hash() const;
+
+    private:
+        // Bodies are numbered mallets first, then pucks.
+        struct Pair {
+            std::uint32_t a;
+            std::uint32_t b;
+        };
+
+        Disk& get_body(size_t i) {
+            return i < mallets.size()? mallets[i] : pucks[i - mallets.size()];
+        }
+
+        void integrate(const std::vector<Action>& actions, double h);
+
+        void collide_with_rink();
+
+        // candidate pairs, sorted, into pairs
+        void find_pairs_brute_force();
+
+        void find_pairs_sweep_and_prune();
+
+        void collide_pairs();
+
+        Parameter_set parameters;
+        const Rink* rink;
+        Broadphase broadphase;
+        std::vector<Disk> mallets;
+        std::vector<Disk> pucks;
+        // sweep and prune: bodies by the left edge of their bounding box,
+        // as of the previous substep
+        std::vector<std::uint32_t> order;
+        // a body was added or removed since order was sorted
+        bool order_stale;
+        std::vector<AABB> boxes;
+        std::vector<Pair> pairs;
+        size_t last_pair_tests;
+};
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "geometry.hpp"
+#include "vector_pack.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace ash {
+
+// A fixed set of boxes, such as the walls and barriers of a rink, stored as
+// structure of arrays so that a disk is tested against all of them at once:
+// a pack of boxes per pass, every lane going through every case of the
+// narrow phase and the results blended. The only branches skip the packs
+// with no box within reach. The set is padded with boxes out of reach to a
+// whole number of packs.
+class Packed_boxes {
+    public:
+        typedef Double_pack<native_lanes> Pack;
+
+        static constexpr size_t capacity = 16;
+
+        // what collides(box, disk) returns for every box, as arrays
+        struct Contacts {
+            // bit i set if the disk touches box i
+            std::uint32_t mask;
+            std::array<double,capacity> penetration;
+            std::array<double,capacity> normal_x;
+            std::array<double,capacity> normal_y;
+        };
+
+        // at most capacity boxes
+        explicit Packed_boxes(const std::vector<AABB>& boxes);
+
+        size_t size() const {
+            return count;
+        }
+
+        // Tests the disk against every box. The results are those of
+        // broadphase_test followed by collides(box, disk), bit for bit;
+        // the penetration and normal of the boxes not touched are
+        // meaningless.
+        void collide(const Vector_2d& position, double radius,
+                Contacts& out) const;
+
+    private:
+        size_t count;
+        size_t padded_count;
+        std::array<double,capacity> x_min;
+        std::array<double,capacity> x_max;
+        std::array<double,capacity> y_min;
+        std::array<double,capacity> y_max;
+};
+
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <SFML/Network.hpp>
+#include "game_state.hpp"
+
+
+namespace ash {
+
+// What the server and the client send each other, field by field in the
+// byte order of sf::Packet. A Game_state is read back into the environment
+// it is read into, with set_state.
+
+sf::Packet& operator<<(sf::Packet& packet, const Vector_2d& v);
+
+sf::Packet& operator>>(sf::Packet& packet, Vector_2d& v);
+
+sf::Packet& operator<<(sf::Packet& packet,
+        const Environment::State::BodyStatus& status);
+
+sf::Packet& operator>>(sf::Packet& packet,
+        Environment::State::BodyStatus& status);
+
+sf::Packet& operator<<(sf::Packet& packet, const Environment::State& state);
+
+sf::Packet& operator>>(sf::Packet& packet, Environment::State& state);
+
+sf::Packet& operator<<(sf::Packet& packet, const Game_state& state);
+
+sf::Packet& operator>>(sf::Packet& packet, Game_state& state);
+
+}
@@ -1,27 +1,171 @@
+#pragma once
 
+#include <algorithm>
+#include <type_traits>
 
-namespace ash::parameters {
 
-constexpr double dt = 0.001;
-constexpr double slop = 0.0005;
+namespace ash {
+
+// Everything that can be tuned about a table. Derived quantities are
+// member functions, so that they follow the values they depend on.
+struct Parameter_set {
+    int substeps;
+    double dt;
+    double slop;
+    double positional_correction;
+    double field_length;
+    double field_width;
+    double goal_width;
+    double mallet_radius;
+    double mallet_mass;
+    double puck_radius;
+    double puck_mass;
+    double puck_mu;
+    double gravity;
+    double mallet_max_velocity;
+    double mallet_wall_restitution;
+    double mallet_puck_restitution;
+    double puck_wall_restitution;
+    double wall_thickness;
+    double kp;
+    double kd;
+    // swept puck: contacts resolved within a single substep
+    int max_swept_impacts;
+    // grid spacing of the distance field of the static rink
+    double static_field_resolution;
+    // sleeping bodies: a body falls asleep after sleep_ticks ticks slower
+    // than sleep_velocity (and, for a mallet, pushed by the controller with
+    // less than sleep_force)
+    double sleep_velocity;
+    int sleep_ticks;
+
+    constexpr double substep_dt() const {
+        return dt/substeps;
+    }
+
+    // adaptive substepping: no body may travel further than the thinnest
+    // wall (or the puck radius) during a substep, so nothing can tunnel
+    // through
+    constexpr double max_substep_travel() const {
+        return std::min(puck_radius, wall_thickness);
+    }
+
+    constexpr int max_substeps() const {
+        return 8*substeps;
+    }
+
+    // within 0.1 mm of its target
+    constexpr double sleep_force() const {
+        return kp*1e-4;
+    }
+};
+
+// The table the game is played on. Code that does not deal with other
+// configurations uses these constants directly.
+namespace parameters {
+
+constexpr int substeps = 10;
+constexpr double dt = 0.02;
+constexpr double slop = 1e-6;
 constexpr double positional_correction = 0.5;
 constexpr double field_length = 1.948;
 constexpr double field_width = 1.038;
 constexpr double goal_width = 0.25;
 constexpr double mallet_radius = 0.04815;
 constexpr double mallet_mass = 0.17;
-constexpr double mallet_accel_force = 5;
-constexpr double mallet_brake_force = 5;
-constexpr double max_mallet_velocity = 2.5;
 constexpr double puck_radius = 0.03165;
 constexpr double puck_mass = 0.015;
 constexpr double puck_mu = 0.01;
 constexpr double gravity = 9.81;
+constexpr double mallet_max_velocity = 4;
 constexpr double mallet_wall_restitution = 0.2;
 constexpr double mallet_puck_restitution = 0.6;
 constexpr double puck_wall_restitution = 0.9;
-constexpr double wall_thickness = 0.04815;
+constexpr double wall_thickness = 0.02;
+constexpr double kp = 150;
+constexpr double kd = 10;
+// swept puck: contacts resolved within a single substep
+constexpr int max_swept_impacts = 4;
+// grid spacing of the distance field of the static rink
+constexpr double static_field_resolution = 0.004;
+// sleeping bodies (see Parameter_set)
+constexpr double sleep_velocity = 1e-3;
+constexpr int sleep_ticks = 5;
 
 }
 
+// The configurations we ship. Each of them has a specialized instantiation
+// of Basic_environment (see Constant_parameters), any other set goes
+// through Runtime_parameters.
+
+inline constexpr Parameter_set default_parameters = {
+    parameters::substeps, parameters::dt, parameters::slop,
+    parameters::positional_correction, parameters::field_length,
+    parameters::field_width, parameters::goal_width,
+    parameters::mallet_radius, parameters::mallet_mass,
+    parameters::puck_radius, parameters::puck_mass, parameters::puck_mu,
+    parameters::gravity, parameters::mallet_max_velocity,
+    parameters::mallet_wall_restitution,
+    parameters::mallet_puck_restitution, parameters::puck_wall_restitution,
+    parameters::wall_thickness, parameters::kp, parameters::kd,
+    parameters::max_swept_impacts, parameters::static_field_resolution,
+    parameters::sleep_velocity, parameters::sleep_ticks};
+
+// The derived quantities of the table, as defined in Parameter_set.
+namespace parameters {
 
+constexpr double substep_dt = default_parameters.substep_dt();
+constexpr double max_substep_travel = default_parameters.max_substep_travel();
+constexpr int max_substeps = default_parameters.max_substeps();
+constexpr double sleep_force = default_parameters.sleep_force();
+
+}
+
+// a 100 Hz server: half the tick, same substep length
+inline constexpr Parameter_set high_rate_parameters = [] {
+    Parameter_set out = default_parameters;
+    out.dt = 0.01;
+    out.substeps = 5;
+    return out;
+}();
+
+// cheap rollouts for the planners: four long substeps per tick, to be used
+// with swept collision detection
+inline constexpr Parameter_set rollout_parameters = [] {
+    Parameter_set out = default_parameters;
+    out.substeps = 4;
+    return out;
+}();
+
+// Source of the parameters of a Basic_environment known at compile time:
+// every use is folded into the generated code, as with the constants above.
+template<const Parameter_set& set>
+struct Constant_parameters {
+    static constexpr const Parameter_set& get() {
+        return set;
+    }
+};
+
+template<class Parameters>
+struct is_constant_parameters : std::false_type {};
+
+template<const Parameter_set& set>
+struct is_constant_parameters<Constant_parameters<set>> : std::true_type {};
+
+// Source of the parameters of a Basic_environment chosen at run time. Each
+// instance carries its own set.
+class Runtime_parameters {
+    public:
+        Runtime_parameters(const Parameter_set& set = default_parameters) :
+            set(set) {
+        }
+
+        const Parameter_set& get() const {
+            return set;
+        }
+
+    private:
+        Parameter_set set;
+};
+
+}
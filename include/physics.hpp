@@ -2,11 +2,19 @@
 
 #include "vector_maths.hpp"
 #include "geometry.hpp"
+#include "distance_field.hpp"
+#include "packed_boxes.hpp"
+#include "fixed_point.hpp"
+#include "dual.hpp"
+#include "parameters.hpp"
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <limits>
 #include <memory>
 #include <optional>
+#include <type_traits>
 
 
 namespace ash {
@@ -16,54 +24,38 @@ constexpr double inf = std::numeric_limits<double>::infinity();
 enum class Body_type : uint64_t {Box, Disk};
 constexpr size_t number_of_body_types = 2;
 
-namespace parameters {
-
-constexpr int substeps = 10;
-constexpr double dt = 0.02;
-constexpr double substep_dt = dt/substeps;
-constexpr double slop = 1e-6;
-constexpr double positional_correction = 0.5;
-constexpr double field_length = 1.948;
-constexpr double field_width = 1.038;
-constexpr double goal_width = 0.25;
-constexpr double mallet_radius = 0.04815;
-constexpr double mallet_mass = 0.17;
-constexpr double puck_radius = 0.03165;
-constexpr double puck_mass = 0.015;
-constexpr double puck_mu = 0.01;
-constexpr double gravity = 9.81;
-constexpr double mallet_max_velocity = 4;
-constexpr double mallet_wall_restitution = 0.2;
-constexpr double mallet_puck_restitution = 0.6;
-constexpr double puck_wall_restitution = 0.9;
-constexpr double wall_thickness = 0.02;
-constexpr double kp = 150;
-constexpr double kd = 10;
-
-}
-
-class Body {
+// Bodies are plain data: there are no virtual functions, the concrete
+// shape is given by a type tag. Code that knows the shapes at compile time
+// (such as Environment::substep) works with Box and Disk directly, while
+// generic code such as the renderer switches on get_type().
+template<class Scalar_type>
+class Basic_body {
     public:
+        typedef Scalar_type Scalar;
+        typedef Basic_vector_2d<Scalar> Vector_2d;
+        typedef Basic_aabb<Scalar> AABB;
 
-        Body(double mass = 1) : inv_mass(1.0 / mass) {
-        }
-
-        Body& set_position(const Vector_2d& position) {
+        constexpr Basic_body& set_position(const Vector_2d& position) {
             this->position = position;
             return *this;
         }
 
-        Body& set_velocity(const Vector_2d& velocity) {
+        Basic_body& set_velocity(const Vector_2d& velocity) {
             this->velocity = velocity;
             return *this;
         }
 
-        Body& apply_force(const Vector_2d& force) {
+        Basic_body& set_force(const Vector_2d& force) {
+            this->force = force;
+            return *this;
+        }
+
+        Basic_body& apply_force(const Vector_2d& force) {
             this->force += force;
             return *this;
         }
 
-        Body& reset_force() {
+        Basic_body& reset_force() {
             force.x = force.y = 0;
             return *this;
         }
@@ -80,108 +72,324 @@ class Body {
             return force;
         }
 
-        double get_mass() const {
-            return inv_mass==0? inf : (1.0/inv_mass);
+        Scalar get_mass() const {
+            return inv_mass==0? std::numeric_limits<Scalar>::infinity() :
+                (Scalar(1)/inv_mass);
         }
 
-        double get_inv_mass() const {
+        Scalar get_inv_mass() const {
             return inv_mass;
         }
 
-        virtual Body_type get_type() const = 0;
+        Body_type get_type() const {
+            return type;
+        }
 
-        virtual AABB get_bounding_box() const = 0;
+        AABB get_bounding_box() const;
 
-        virtual ~Body() = default;
+    protected:
+
+        constexpr Basic_body(Body_type type, Scalar mass) :
+            inv_mass(mass == std::numeric_limits<Scalar>::infinity()?
+                    Scalar(0) : Scalar(1) / mass),
+            type(type) {
+        }
 
     private:
         Vector_2d position;
         Vector_2d velocity;
         Vector_2d force;
-        double inv_mass;
+        Scalar inv_mass;
+        Body_type type;
 };
 
-class Box : public Body {
+template<class Scalar>
+class Basic_box : public Basic_body<Scalar> {
     public:
-        Box(const Vector_2d& size = Vector_2d(1,1), double mass = 1) :
-            Body(mass), size(size) {}
+        typedef Basic_vector_2d<Scalar> Vector_2d;
+        typedef Basic_aabb<Scalar> AABB;
+
+        constexpr Basic_box(const Vector_2d& size = Vector_2d(1,1),
+                Scalar mass = 1) :
+            Basic_body<Scalar>(Body_type::Box, mass), size(size),
+            half_size(size/2) {}
 
         const Vector_2d& get_size() const {
             return size;
         }
 
-        Body_type get_type() const override {
-            return Body_type::Box;
+        AABB get_bounding_box() const {
+            const auto& position = this->get_position();
+            AABB result;
+            result.x_min = position.x - half_size.x;
+            result.x_max = position.x + half_size.x;
+            result.y_min = position.y - half_size.y;
+            result.y_max = position.y + half_size.y;
+            return result;
         }
 
-        AABB get_bounding_box() const override;
-
     private:
         Vector_2d size;
+        // kept apart, as a division costs much more than an addition in
+        // fixed point
+        Vector_2d half_size;
 };
 
-class Disk : public Body {
+template<class Scalar>
+class Basic_disk : public Basic_body<Scalar> {
     public:
-        Disk(double radius = 1, double mass = 1) :
-            Body(mass), radius(radius) {
+        typedef Basic_aabb<Scalar> AABB;
+
+        Basic_disk(Scalar radius = 1, Scalar mass = 1) :
+            Basic_body<Scalar>(Body_type::Disk, mass), radius(radius) {
         }
 
-        double get_radius() const {
+        Scalar get_radius() const {
             return radius;
         }
 
-        Body_type get_type() const override {
-            return Body_type::Disk;
+        AABB get_bounding_box() const {
+            const auto& position = this->get_position();
+            AABB result;
+            result.x_min = position.x - radius;
+            result.x_max = position.x + radius;
+            result.y_min = position.y - radius;
+            result.y_max = position.y + radius;
+            return result;
         }
 
-        AABB get_bounding_box() const override;
-
     private:
-        double radius;
+        Scalar radius;
 
 };
 
-struct Collision {
-    Body* a;
-    Body* b;
-    Vector_2d normal;
-    double penetration;
+typedef Basic_body<double> Body;
+typedef Basic_box<double> Box;
+typedef Basic_disk<double> Disk;
+
+template<class Scalar>
+struct Basic_collision {
+    Basic_body<Scalar>* a;
+    Basic_body<Scalar>* b;
+    Basic_vector_2d<Scalar> normal;
+    Scalar penetration;
 };
 
-bool broadphase_test(const Body& a, const Body& b);
+typedef Basic_collision<double> Collision;
 
-std::optional<Collision> collides(Body& a, Body& b);
+// Shares of a and b in the response to a collision: their inverse masses
+// over the sum of both. They only depend on the masses, so callers that
+// meet the same pair again and again can work them out once (see
+// response_weights).
+template<class Scalar>
+struct Basic_response_weights {
+    Scalar a;
+    Scalar b;
+};
 
-void resolve_collision(Collision& collision, double restitution = 1.0);
+// The static part of a table: the walls around the field, and the barriers
+// that keep the mallets out of the goals and in their own half. Nothing
+// moves it, so every environment on the same rink refers to a single
+// instance instead of carrying its own.
+template<class Scalar>
+struct Basic_rink {
+    typedef std::array<Basic_box<Scalar>,6> Wall_array;
+    typedef std::array<Basic_box<Scalar>,3> Barrier_array;
+
+    Wall_array walls;
+    Barrier_array barriers;
+};
 
-void correct_position(
-        Collision& collision, double slop, double amount);
+typedef Basic_rink<double> Rink;
 
-class Environment {
-    public:
-        struct State {
-            struct BodyStatus {
-                Vector_2d position;
-                Vector_2d velocity;
-            };
-
-            std::array<BodyStatus,2> mallets;
-            BodyStatus puck;
+template<class A, class B>
+bool broadphase_test(const A& a, const B& b) {
+    return a.get_bounding_box().intersects(b.get_bounding_box());
+}
+
+// Statically dispatched narrow phase, for callers that know the shapes
+template<class Scalar>
+std::optional<Basic_collision<Scalar>> collides(Basic_box<Scalar>& a,
+        Basic_box<Scalar>& b);
+
+template<class Scalar>
+std::optional<Basic_collision<Scalar>> collides(Basic_box<Scalar>& a,
+        Basic_disk<Scalar>& b);
+
+template<class Scalar>
+std::optional<Basic_collision<Scalar>> collides(Basic_disk<Scalar>& a,
+        Basic_box<Scalar>& b);
+
+template<class Scalar>
+std::optional<Basic_collision<Scalar>> collides(Basic_disk<Scalar>& a,
+        Basic_disk<Scalar>& b);
+
+// Narrow phase dispatched on the type tags of the bodies
+template<class Scalar>
+std::optional<Basic_collision<Scalar>> collides(Basic_body<Scalar>& a,
+        Basic_body<Scalar>& b);
+
+template<class Scalar>
+Basic_response_weights<Scalar> response_weights(Scalar inv_mass_a,
+        Scalar inv_mass_b);
+
+template<class Scalar>
+void resolve_collision(Basic_collision<Scalar>& collision,
+        Scalar restitution = 1);
+
+template<class Scalar>
+void resolve_collision(Basic_collision<Scalar>& collision,
+        Scalar restitution, const Basic_response_weights<Scalar>& weights);
+
+template<class Scalar>
+void correct_position(Basic_collision<Scalar>& collision, Scalar slop,
+        Scalar amount);
+
+template<class Scalar>
+void correct_position(Basic_collision<Scalar>& collision, Scalar slop,
+        Scalar amount, const Basic_response_weights<Scalar>& weights);
+
+// The state and the settings of a Basic_environment do not depend on its
+// parameters, so they carry over between tables of different
+// configurations.
+template<class Scalar>
+struct Basic_environment_types {
+    struct State {
+        struct BodyStatus {
+            Basic_vector_2d<Scalar> position;
+            Basic_vector_2d<Scalar> velocity;
         };
-        typedef Vector_2d Action;
-        typedef std::array<Box,6> Wall_array;
-        typedef std::array<Box,3> Barrier_array;
+
+        std::array<BodyStatus,2> mallets;
+        BodyStatus puck;
+    };
+
+    // Everything a step reads or writes, unlike State: restoring a snapshot
+    // resumes the simulation exactly where it was taken, sleeping bodies and
+    // pending forces included. The settings are not part of it.
+    struct Snapshot {
+        struct Body_snapshot {
+            Basic_vector_2d<Scalar> position;
+            Basic_vector_2d<Scalar> velocity;
+            Basic_vector_2d<Scalar> force;
+        };
+
+        std::array<Body_snapshot,2> mallets;
+        Body_snapshot puck;
+        std::array<int,2> mallet_rest_ticks;
+        int puck_rest_ticks;
+        int last_substeps;
+        std::array<bool,2> mallet_asleep;
+        bool puck_asleep;
+        bool last_fast_path;
+    };
+
+    typedef Basic_vector_2d<Scalar> Action;
+
+    enum class Substepping {
+        // substeps substeps of substep_dt
+        fixed,
+        // as few substeps as max_substep_travel allows
+        adaptive
+    };
+
+    enum class Integrator {
+        // what the game has always used, first order
+        semi_implicit_euler,
+        // second order, with a predicted velocity for the damping term
+        velocity_verlet,
+        // classic fourth order Runge-Kutta for the mallets
+        runge_kutta
+    };
+
+    // Counters of the contact cache for one pair of bodies. Pairs are
+    // numbered in the order they are tested: walls x mallets (0-11),
+    // barriers x mallets (12-17), walls x puck (18-23) and mallets x puck
+    // (24-25).
+    struct Contact_stats {
+        // tests skipped because the bodies could not reach each other
+        size_t skipped;
+        // tests run
+        size_t tested;
+        // tests that found the bodies in contact
+        size_t contacts;
+    };
+
+    static constexpr size_t pair_count = 26;
+    typedef std::array<Contact_stats,pair_count> Contact_stats_array;
+
+    enum class Static_collision {
+        // every wall and barrier is tested on its own
+        boxes,
+        // one lookup in a precomputed distance field per disk
+        field,
+        // every wall and barrier tested at once per disk (see
+        // Packed_boxes), with the same results as boxes; the same as boxes
+        // for scalars other than double
+        packed
+    };
+
+    enum class Collision_detection {
+        // bodies are moved and then pushed out of whatever they overlap
+        discrete,
+        // the puck is swept against walls and mallets, so that it cannot
+        // tunnel through them however long the substep is
+        swept
+    };
+};
+
+// Parameters_type is where the parameters come from: Constant_parameters
+// for the configurations compiled in, Runtime_parameters for the others.
+template<class Scalar_type,
+    class Parameters_type = Constant_parameters<default_parameters>>
+class Basic_environment {
+    public:
+        typedef Scalar_type Scalar;
+        typedef Parameters_type Parameters;
+        typedef Basic_vector_2d<Scalar> Vector_2d;
+        typedef Basic_aabb<Scalar> AABB;
+        typedef Basic_impact<Scalar> Impact;
+        typedef Basic_body<Scalar> Body;
+        typedef Basic_box<Scalar> Box;
+        typedef Basic_disk<Scalar> Disk;
+        typedef Basic_collision<Scalar> Collision;
+        typedef Basic_distance_field<Scalar> Distance_field;
+        typedef Basic_rink<Scalar> Rink;
+
+        typedef Basic_environment_types<Scalar> Types;
+        typedef typename Types::State State;
+        typedef typename Types::Snapshot Snapshot;
+        typedef typename Types::Action Action;
+        typedef typename Rink::Wall_array Wall_array;
+        typedef typename Rink::Barrier_array Barrier_array;
         typedef std::array<Disk,2> Mallet_array;
         typedef std::array<int,2> Score_array;
+        typedef typename Types::Substepping Substepping;
+        typedef typename Types::Integrator Integrator;
+        typedef typename Types::Contact_stats Contact_stats;
+        static constexpr size_t pair_count = Types::pair_count;
+        typedef typename Types::Contact_stats_array Contact_stats_array;
+        typedef typename Types::Static_collision Static_collision;
+        typedef typename Types::Collision_detection Collision_detection;
+
+        explicit Basic_environment(const Parameters& parameters =
+                Parameters());
+
+        const Parameter_set& get_parameters() const {
+            return parameters.get();
+        }
 
-        Environment();
+        // shared by every environment with the same geometry
+        const Rink& get_rink() const {
+            return *rink;
+        }
 
         const Wall_array& get_walls() const {
-            return walls;
+            return rink->walls;
         }
 
         const Barrier_array& get_barriers() const {
-            return barriers;
+            return rink->barriers;
         }
 
         const Mallet_array& get_mallets() const {
@@ -196,22 +404,285 @@ class Environment {
 
         int step(const Action& a1, const Action& a2);
 
+        Substepping get_substepping() const {
+            return substepping;
+        }
+
+        void set_substepping(Substepping substepping) {
+            this->substepping = substepping;
+        }
+
+        // number of substeps per step in fixed mode
+        int get_fixed_substeps() const {
+            return fixed_substeps;
+        }
+
+        // at least one, as the adaptive mode
+        void set_fixed_substeps(int fixed_substeps) {
+            this->fixed_substeps = std::max(fixed_substeps, 1);
+        }
+
+        Integrator get_integrator() const {
+            return integrator;
+        }
+
+        void set_integrator(Integrator integrator) {
+            this->integrator = integrator;
+        }
+
+        // Ticks in which no contact can happen skip the collision tests.
+        // Results are the same either way. Like the contact cache, it is
+        // only used with semi-implicit Euler.
+        bool get_fast_path() const {
+            return fast_path;
+        }
+
+        void set_fast_path(bool fast_path) {
+            this->fast_path = fast_path;
+        }
+
+        // The contact cache skips the pairs that cannot touch during a tick.
+        // Like the fast path, it does not change the results. It is only
+        // used with semi-implicit Euler, discrete detection and static boxes.
+        bool get_contact_cache() const {
+            return contact_cache;
+        }
+
+        void set_contact_cache(bool contact_cache) {
+            this->contact_cache = contact_cache;
+        }
+
+        // The counters of the contact cache go to the array given here, if
+        // any (the environment does not own it, and copies of the
+        // environment count into the same array).
+        Contact_stats_array* get_contact_stats() const {
+            return contact_stats;
+        }
+
+        void set_contact_stats(Contact_stats_array* contact_stats) {
+            this->contact_stats = contact_stats;
+        }
+
+        Static_collision get_static_collision() const {
+            return static_collision;
+        }
+
+        void set_static_collision(Static_collision static_collision);
+
+        Collision_detection get_collision_detection() const {
+            return collision_detection;
+        }
+
+        void set_collision_detection(Collision_detection collision_detection) {
+            this->collision_detection = collision_detection;
+        }
+
+        // number of substeps taken by the last call to step
+        int get_last_substeps() const {
+            return last_substeps;
+        }
+
+        // whether the last call to step took the fast path
+        bool get_last_fast_path() const {
+            return last_fast_path;
+        }
+
+        // Bodies at rest fall asleep: they are neither integrated nor
+        // tested against the rink until their controller pushes them again,
+        // a force is applied to them or a moving body touches them. Bodies
+        // are stopped when they fall asleep, so this changes the results
+        // slightly. Only used with semi-implicit Euler.
+        bool get_sleeping() const {
+            return sleeping;
+        }
+
+        void set_sleeping(bool sleeping) {
+            this->sleeping = sleeping;
+            wake_all();
+        }
+
+        bool is_mallet_asleep(size_t i) const {
+            return mallet_asleep[i];
+        }
+
+        bool is_puck_asleep() const {
+            return puck_asleep;
+        }
+
         State get_state() const;
 
         void set_state(const State& state);
 
+        Snapshot get_snapshot() const;
+
+        void restore(const Snapshot& snapshot);
+
+        // FNV-1a hash of the bits of the state. In fixed point it is the
+        // same on every machine, so two runs can be compared tick by tick.
+        std::uint64_t get_state_hash() const;
+
     private:
 
-        void handle_collision(Body& a, Body& b, double restitution);
+        // distance fields of the walls (for the puck) and of the walls and
+        // barriers (for the mallets)
+        struct Static_fields {
+            Distance_field puck;
+            Distance_field mallets;
+        };
+
+        // built the first time they are needed, shared by all instances on
+        // the same rink
+        const Static_fields& get_static_fields() const;
 
-        int substep(const Action& a1, const Action& a2);
+        // the walls (for the puck) and the walls and barriers (for the
+        // mallets), in the order of the rink
+        struct Packed_rink {
+            Packed_boxes puck;
+            Packed_boxes mallets;
+        };
+
+        // shared as the static fields
+        const Packed_rink& get_packed_rink() const;
+
+        // slack for the rounding errors of the conservative bounds used by
+        // the fast path and the contact cache
+        static constexpr double bound_margin = std::max(1e-9,
+                1e3*static_cast<double>(
+                    std::numeric_limits<Scalar>::epsilon()));
+
+        // Bounds of the contact cache for the tick being simulated; they
+        // only live as long as the call to step. They are not kept from one
+        // tick to the next: they start from the velocities of the tick, so
+        // they would have to be computed again anyway, and every copy of
+        // the environment (rollouts, history) would carry them. Nor are the
+        // contacts themselves reused: a mallet pushed against a wall is in
+        // contact every substep, and only resolving it again gives the same
+        // results as without the cache.
+        struct Contact_cache;
+
+        // The substeps of the mallets for the tick being simulated (their
+        // length and the gains of the controller), worked out once per
+        // step.
+        struct Mallet_steppers;
+
+        // bodies as numbered by the contact cache
+        const Body& get_body(size_t slot) const;
+
+        void prepare_contact_cache(Contact_cache& cache, int n,
+                Scalar h) const;
+
+        // returns whether a and b were in contact
+        template<class A, class B>
+        bool handle_collision(A& a, B& b, Scalar restitution, size_t pair,
+                Contact_cache& cache);
+
+        void update_sleep(const Action& a1, const Action& a2);
+
+        void wake_all() {
+            mallet_asleep = {};
+            puck_asleep = false;
+            mallet_rest_ticks = {};
+            puck_rest_ticks = 0;
+        }
+
+        bool collide_mallet_with_puck(size_t j, Contact_cache& cache);
+
+        void collide_mallets_with_rink(Contact_cache& cache);
+
+        void collide_puck_with_rink(Contact_cache& cache);
+
+        // false if the disk is out of the field
+        bool collide_with_field(const Distance_field& field, Disk& disk,
+                Scalar restitution);
+
+        // Resolves the contacts found by boxes.collide one box at a time,
+        // in order. A contact that moves the disk invalidates the tests of
+        // the boxes after it, which are run again. Only for double.
+        void collide_with_packed(const Packed_boxes& boxes, Disk& disk,
+                Scalar restitution);
+
+        // conservative test: true if no collision test can succeed during
+        // the next n substeps of length h
+        bool contact_free(const Action& a1, const Action& a2, int n,
+                Scalar h) const;
+
+        // fewest substeps that keep every body within max_substep_travel
+        // during the next step
+        int adaptive_substeps(const Action& a1, const Action& a2) const;
+
+        int substep(const Action& a1, const Action& a2, Scalar h,
+                const Mallet_steppers& steppers, Contact_cache& cache);
+
+        void integrate(const Action& a1, const Action& a2, Scalar h,
+                const Mallet_steppers& steppers);
+
+        void integrate_verlet(const Action& a1, const Action& a2, Scalar h);
+
+        void integrate_runge_kutta(const Action& a1, const Action& a2,
+                Scalar h);
+
+        // exact motion of the puck under constant friction, for the higher
+        // order integrators
+        void advance_puck(Scalar h);
+
+        // n substeps of integrate in a row, for ticks without contacts
+        void integrate_free(const Action& a1, const Action& a2, int n,
+                Scalar h, const Mallet_steppers& steppers);
+
+        int check_goal() const;
+
+        // moves the puck from start along its velocity, bouncing it off the
+        // first wall or mallet in its way
+        void sweep_puck(const Vector_2d& start,
+                const std::array<Vector_2d,2>& mallet_start, Scalar h);
+
+        std::optional<Impact> sweep_puck_vs_walls(const Vector_2d& position,
+                const Vector_2d& displacement) const;
+
+        Parameters parameters;
+        const Rink* rink;
+        Substepping substepping;
+        int fixed_substeps;
+        Integrator integrator;
+        bool fast_path;
+        Static_collision static_collision;
+        const Static_fields* static_fields;
+        const Packed_rink* packed_rink;
+        bool contact_cache;
+        Contact_stats_array* contact_stats;
+        bool sleeping;
+        std::array<bool,2> mallet_asleep;
+        bool puck_asleep;
+        // ticks spent at rest so far
+        std::array<int,2> mallet_rest_ticks;
+        int puck_rest_ticks;
+        Collision_detection collision_detection;
+        int last_substeps;
+        bool last_fast_path;
 
     public:
-        Wall_array walls;
-        Barrier_array barriers;
         Mallet_array mallets;
         Disk puck;
-        
 };
 
+typedef Basic_environment<double> Environment;
+// half the state, at the cost of trajectories that part ways with the
+// double ones after a few hundred ticks (see precision_benchmark)
+typedef Basic_environment<float> Float_environment;
+// bit for bit the same results on every machine, for lockstep and replays
+typedef Basic_environment<Fixed> Fixed_environment;
+// derivatives of the state with respect to up to 16 seeded inputs (see
+// Dual), for planning by gradient
+typedef Basic_environment<Dual_scalar> Dual_environment;
+// any parameter set, at the cost of loading every parameter from memory
+typedef Basic_environment<double, Runtime_parameters> Runtime_environment;
+template<const Parameter_set& set>
+using Constant_environment = Basic_environment<double,
+      Constant_parameters<set>>;
+
+// Tree search copies environments by the million: they hold the moving
+// bodies and the settings, and nothing that a memcpy cannot copy.
+static_assert(std::is_trivially_copyable_v<Environment>);
+static_assert(std::is_trivially_copyable_v<Runtime_environment>);
+
 }
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "physics.hpp"
+
+#include <array>
+#include <random>
+
+
+namespace ash {
+
+// A short plan for one mallet: its target during each of the next
+// plan_length ticks. The planners below assume that the other mallet stays
+// where it is.
+constexpr size_t plan_length = Dual_scalar::size/2;
+typedef std::array<Vector_2d,plan_length> Plan;
+
+// Lower is better. At the end of the plan: the distance from the puck to
+// the goal of the opponent, minus a bonus for the speed of the puck towards
+// it. Over the plan: the closest the mallet gets to the puck, so that plans
+// that miss the puck still lead towards it. A goal ends the plan early,
+// with a bonus for scoring and a penalty for conceding.
+double plan_cost(const Environment::State& state, int player,
+        const Plan& plan);
+
+// every target on the puck
+Plan initial_plan(const Environment::State& state);
+
+// the plan for the next tick: one tick less, and the last target held
+Plan shift_plan(const Plan& plan);
+
+// Gradient descent on the targets. Every iteration rolls the plan out once
+// in a Dual_environment, which gives the cost and its derivatives with
+// respect to all the targets at once; the step grows while the cost goes
+// down and shrinks when it does not.
+class Gradient_planner {
+    public:
+        explicit Gradient_planner(int player, int iterations = 10);
+
+        int get_iterations() const {
+            return iterations;
+        }
+
+        void set_iterations(int iterations) {
+            this->iterations = iterations;
+        }
+
+        Plan improve(const Environment::State& state, Plan plan) const;
+
+        // cost of the plan, and its derivatives with respect to the x and y
+        // of each target in turn
+        double get_cost_gradient(const Environment::State& state,
+                const Plan& plan, Dual_scalar::Gradient& gradient) const;
+
+    private:
+        int player;
+        int iterations;
+};
+
+// Random search: every sample perturbs the best plan so far and is kept if
+// it costs less. Each sample is one rollout in Environment.
+class Sampling_planner {
+    public:
+        explicit Sampling_planner(int player, int samples = 100,
+                unsigned seed = 0);
+
+        int get_samples() const {
+            return samples;
+        }
+
+        void set_samples(int samples) {
+            this->samples = samples;
+        }
+
+        Plan improve(const Environment::State& state, Plan plan);
+
+    private:
+        int player;
+        int samples;
+        std::mt19937 rng;
+};
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "physics.hpp"
+
+#include <array>
+#include <optional>
+
+
+namespace ash {
+
+// Path of a puck that no mallet touches: straight segments along which
+// friction slows the puck down at a constant rate, joined by bounces off
+// the walls. The path follows the discretization of Environment (fixed
+// substeps of substep_dt, semi-implicit Euler): at the end of every
+// substep it is where step would put the puck, up to rounding.
+class Puck_path {
+    public:
+        static constexpr size_t max_segments = 32;
+
+        struct Segment {
+            double start_time;
+            Vector_2d start;
+            // unit vector
+            Vector_2d direction;
+            // at start_time
+            double speed;
+            // bounce, goal, stop or horizon
+            double end_time;
+        };
+
+        // t must not be negative; after the end of the path the puck stays
+        // where the path leaves it
+        Vector_2d get_position(double t) const;
+
+        Vector_2d get_velocity(double t) const;
+
+        // first time the centre of the puck reaches the line x = x, if it
+        // does along the path
+        std::optional<double> get_time_to_line(double x) const;
+
+        // as returned by Environment::step: -1 if no goal is scored along
+        // the path
+        int get_winner() const {
+            return winner;
+        }
+
+        // infinity if no goal is scored along the path
+        double get_goal_time() const {
+            return goal_time;
+        }
+
+        // infinity if the puck is still moving at the end of the path
+        double get_stop_time() const {
+            return stop_time;
+        }
+
+        size_t get_segment_count() const {
+            return segment_count;
+        }
+
+        const Segment& get_segment(size_t i) const {
+            return segments[i];
+        }
+
+        size_t get_bounces() const {
+            return segment_count == 0? 0 : segment_count - 1;
+        }
+
+    private:
+        friend class Puck_predictor;
+
+        // distance covered along a segment, tau seconds into it
+        double travelled(const Segment& segment, double tau) const;
+
+        // time taken to cover a distance along a segment
+        double time_to_travel(const Segment& segment, double distance) const;
+
+        const Segment& find_segment(double t) const;
+
+        double deceleration;
+        double substep;
+        std::array<Segment,max_segments> segments;
+        size_t segment_count;
+        int winner;
+        double goal_time;
+        double stop_time;
+};
+
+// Predicts the path of the puck in closed form. The straight stretches
+// cost the same whatever their length, and only the substeps in which the
+// puck touches a wall are simulated, so a prediction costs about as much as
+// a few substeps instead of one per substep of the whole horizon.
+class Puck_predictor {
+    public:
+        explicit Puck_predictor(
+                const Parameter_set& parameters = default_parameters);
+
+        // path of the puck of the state during the next horizon seconds, or
+        // until it stops or a goal is scored (the mallets are ignored)
+        Puck_path predict(const Environment::State& state,
+                double horizon) const;
+
+    private:
+        Parameter_set parameters;
+        Rink rink;
+};
+
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "physics.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+namespace ash {
+
+// Steps a set of Environment objects on a pool of threads. The tables are
+// split in chunks and every worker starts a step with its own contiguous
+// range of chunks. Once that range is exhausted it steals chunks from the
+// ranges of the other workers, so that a slow worker does not hold back the
+// whole step.
+class Rollout_pool {
+    public:
+        typedef std::array<Environment::Action,2> Action_pair;
+
+        struct Result {
+            // state the next step starts from (after the reset when a goal
+            // has been scored)
+            Environment::State state;
+            // winner code returned by Environment::step
+            int winner;
+        };
+
+        struct Worker_stats {
+            double busy_seconds;
+            // busy time over the wall time spent inside step()
+            double utilization;
+            size_t chunks;
+            size_t steals;
+        };
+
+        explicit Rollout_pool(size_t tables,
+                size_t workers = std::thread::hardware_concurrency());
+
+        Rollout_pool(const Rollout_pool&) = delete;
+
+        Rollout_pool& operator=(const Rollout_pool&) = delete;
+
+        ~Rollout_pool();
+
+        size_t size() const {
+            return environments.size();
+        }
+
+        size_t get_workers() const {
+            return workers.size();
+        }
+
+        const Environment& get_environment(size_t table) const {
+            return environments[table];
+        }
+
+        Environment& get_environment(size_t table) {
+            return environments[table];
+        }
+
+        // Steps every table with its pair of actions. Finished tables are
+        // reset, alternating the sender like Server_loop does.
+        const std::vector<Result>& step(const std::vector<Action_pair>& actions);
+
+        std::vector<Worker_stats> get_worker_stats() const;
+
+        void reset_worker_stats();
+
+    private:
+
+        struct alignas(64) Worker {
+            std::atomic<size_t> next_chunk;
+            size_t end_chunk;
+            std::thread thread;
+            double busy_seconds;
+            size_t chunks;
+            size_t steals;
+        };
+
+        void run(size_t index);
+
+        bool run_chunk(size_t owner);
+
+        void step_chunk(size_t chunk);
+
+        std::vector<Environment> environments;
+        std::vector<int> senders;
+        std::vector<Result> results;
+        const std::vector<Action_pair>* actions;
+        size_t chunk_size;
+        size_t chunk_count;
+        std::vector<Worker> workers;
+        double wall_seconds;
+
+        std::mutex mtx;
+        std::condition_variable start_cv;
+        std::condition_variable done_cv;
+        size_t generation;
+        size_t finished;
+        bool stopping;
+};
+
+}
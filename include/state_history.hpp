@@ -0,0 +1,89 @@
+#pragma once
+
+#include "physics.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+
+namespace ash {
+
+// What the ticks of a match change: the table, and the score and the side
+// that serves after a goal.
+struct Match {
+    Environment environment;
+    std::array<int,2> score;
+    int sender;
+};
+
+// Steps a match by one tick the way the server does: after a goal the
+// score goes up and the player who conceded it serves. Returns the winner
+// of the point, or -1.
+int play_tick(Match& match, const Environment::Action& input1,
+        const Environment::Action& input2);
+
+// The last ticks of a match: the state each of them started from and the
+// inputs it was played with, in a ring allocated once. A server that gets
+// an input late (or a correction of one) rewinds to its tick and plays the
+// ticks up to the present again. Ticks are numbered from 0 in the order
+// they are recorded.
+class State_history {
+    public:
+        typedef Environment::Action Action;
+        typedef std::array<Action,2> Input_pair;
+
+        explicit State_history(size_t capacity);
+
+        size_t get_capacity() const {
+            return entries.size();
+        }
+
+        // number of the next tick to be recorded
+        std::uint64_t get_end() const {
+            return end;
+        }
+
+        // oldest tick still in the ring
+        std::uint64_t get_begin() const {
+            return end > entries.size()? end - entries.size() : 0;
+        }
+
+        bool contains(std::uint64_t tick) const {
+            return get_begin() <= tick && tick < end;
+        }
+
+        // Records tick get_end(): to be called right before the match is
+        // stepped with the inputs.
+        void record(const Match& match, const Input_pair& inputs);
+
+        // the tick must be in the ring
+        const Input_pair& get_inputs(std::uint64_t tick) const {
+            return entries[tick % entries.size()].inputs;
+        }
+
+        // replaces an input, for resimulate to use
+        void set_input(std::uint64_t tick, size_t player, const Action& input);
+
+        // puts the match back at the beginning of the tick
+        void rewind(std::uint64_t tick, Match& match) const;
+
+        // Rewinds to the tick and plays it and the following ones again with
+        // their recorded inputs, recording the new states on the way. The
+        // match ends up at the beginning of tick get_end(). Returns the
+        // number of goals scored during the replay.
+        int resimulate(std::uint64_t tick, Match& match);
+
+    private:
+        struct Entry {
+            Environment::Snapshot snapshot;
+            std::array<int,2> score;
+            int sender;
+            Input_pair inputs;
+        };
+
+        std::vector<Entry> entries;
+        std::uint64_t end;
+};
+
+}
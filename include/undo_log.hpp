@@ -0,0 +1,74 @@
+#pragma once
+
+#include "physics.hpp"
+
+#include <cassert>
+#include <vector>
+
+
+namespace ash {
+
+// Lets a search step an environment forward and take the steps back again,
+// instead of copying the environment at every node. Steps and resets go
+// through the log, which keeps a snapshot of the state each of them
+// overwrote; the snapshots are reused, so a search that goes up and down
+// the same depths does not allocate.
+template<class Environment_type>
+class Basic_undo_log {
+    public:
+        typedef Environment_type Environment;
+        typedef typename Environment::Action Action;
+        typedef typename Environment::Snapshot Snapshot;
+
+        explicit Basic_undo_log(Environment& environment) :
+            environment(&environment) {
+        }
+
+        Environment& get_environment() const {
+            return *environment;
+        }
+
+        int step(const Action& a1, const Action& a2) {
+            entries.push_back(environment->get_snapshot());
+            return environment->step(a1, a2);
+        }
+
+        void reset(size_t sender) {
+            entries.push_back(environment->get_snapshot());
+            environment->reset(sender);
+        }
+
+        // number of steps and resets that can be undone
+        size_t get_depth() const {
+            return entries.size();
+        }
+
+        // takes back the last step or reset
+        void undo() {
+            assert(!entries.empty());
+            environment->restore(entries.back());
+            entries.pop_back();
+        }
+
+        // takes back everything done since the log was depth entries deep
+        void undo_to(size_t depth) {
+            assert(depth <= entries.size());
+            if (depth < entries.size()) {
+                environment->restore(entries[depth]);
+                entries.resize(depth);
+            }
+        }
+
+        // forgets the history, keeping the environment as it is
+        void clear() {
+            entries.clear();
+        }
+
+    private:
+        Environment* environment;
+        std::vector<Snapshot> entries;
+};
+
+typedef Basic_undo_log<Environment> Undo_log;
+
+}
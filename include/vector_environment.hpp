@@ -0,0 +1,159 @@
+#pragma once
+
+#include "physics.hpp"
+
+#include <cstdint>
+#include <vector>
+
+
+namespace ash {
+
+// N independent tables stored in structure-of-arrays form. Every lane
+// loop in step() walks all the tables for one body (or one body pair), so
+// the compiler can pack several tables per vector instruction.
+class Vector_environment {
+    public:
+        // reference: same floating point operations, in the same order, as
+        //            Environment::step (bitwise identical results).
+        // fast:      folds constants and skips no-op updates during the
+        //            integration; results may differ in the last bits.
+        enum class Mode {reference, fast};
+
+        typedef std::array<Environment::Action,2> Action_pair;
+
+        // uniform distribution over [min, max]
+        struct Range {
+            double min;
+            double max;
+        };
+
+        // Distributions the parameters of a table are drawn from, for
+        // domain randomization. Every range starts at the nominal value,
+        // that is, without randomization.
+        struct Randomization {
+            Range mallet_wall_restitution = nominal(
+                    parameters::mallet_wall_restitution);
+            Range mallet_puck_restitution = nominal(
+                    parameters::mallet_puck_restitution);
+            Range puck_wall_restitution = nominal(
+                    parameters::puck_wall_restitution);
+            Range puck_mu = nominal(parameters::puck_mu);
+            Range mallet_mass = nominal(parameters::mallet_mass);
+            Range puck_mass = nominal(parameters::puck_mass);
+            Range kp = nominal(parameters::kp);
+            Range kd = nominal(parameters::kd);
+            Range mallet_radius = nominal(parameters::mallet_radius);
+            Range puck_radius = nominal(parameters::puck_radius);
+
+            // The default parameters with the ones above drawn from a
+            // generator seeded with seed. The draws do not depend on the
+            // standard library, so a seed gives the same table everywhere.
+            Parameter_set sample(std::uint64_t seed) const;
+
+            static constexpr Range nominal(double value) {
+                return {value, value};
+            }
+        };
+
+        explicit Vector_environment(size_t size, Mode mode = Mode::reference);
+
+        size_t size() const {
+            return n;
+        }
+
+        Mode get_mode() const {
+            return mode;
+        }
+
+        void set_mode(Mode mode) {
+            this->mode = mode;
+        }
+
+        void reset(size_t table, size_t sender);
+
+        // Parameters of a table. Only the ones in Randomization may differ
+        // between tables, the others are always the defaults.
+        const Parameter_set& get_parameters(size_t table) const {
+            return sets[table];
+        }
+
+        void set_parameters(size_t table, const Parameter_set& set);
+
+        // table i gets randomization.sample(seed + i)
+        void randomize(const Randomization& randomization,
+                std::uint64_t seed);
+
+        // Advances every table one tick. actions[i] holds the targets of
+        // both mallets of table i. Returns, for every table, the same
+        // winner code that Environment::step (or Runtime_environment::step,
+        // with the parameters of the table) would return.
+        const std::vector<int>& step(const std::vector<Action_pair>& actions);
+
+        Environment::State get_state(size_t table) const;
+
+        void set_state(size_t table, const Environment::State& state);
+
+    private:
+
+        struct Lanes {
+            std::vector<double> x;
+            std::vector<double> y;
+            std::vector<double> vx;
+            std::vector<double> vy;
+
+            void resize(size_t n) {
+                x.resize(n);
+                y.resize(n);
+                vx.resize(n);
+                vy.resize(n);
+            }
+        };
+
+        // Parameters of every table, stored like the state so that tables
+        // with different parameters step as fast as identical ones. Some
+        // are kept premultiplied, as the kernels use them.
+        struct Parameter_lanes {
+            std::vector<double> kp;
+            std::vector<double> kd;
+            // kd*mallet_max_velocity
+            std::vector<double> max_p_force;
+            std::vector<double> mallet_radius;
+            std::vector<double> mallet_inv_mass;
+            std::vector<double> puck_radius;
+            std::vector<double> puck_inv_mass;
+            // gravity*puck_mu*substep_dt
+            std::vector<double> friction_dec;
+            std::vector<double> mallet_wall_restitution;
+            std::vector<double> mallet_puck_restitution;
+            std::vector<double> puck_wall_restitution;
+
+            void resize(size_t n) {
+                for (auto* lane : {&kp, &kd, &max_p_force, &mallet_radius,
+                        &mallet_inv_mass, &puck_radius, &puck_inv_mass,
+                        &friction_dec, &mallet_wall_restitution,
+                        &mallet_puck_restitution, &puck_wall_restitution}) {
+                    lane->resize(n);
+                }
+            }
+        };
+
+        // advances the tables in [begin, end) by one substep
+        template<bool exact>
+        void substep(size_t begin, size_t end);
+
+        void check_goals();
+
+        size_t n;
+        Mode mode;
+        std::array<AABB,6> walls;
+        std::array<AABB,3> barriers;
+        std::array<Lanes,2> mallets;
+        Lanes puck;
+        std::array<std::vector<double>,2> target_x;
+        std::array<std::vector<double>,2> target_y;
+        Parameter_lanes lanes;
+        std::vector<Parameter_set> sets;
+        std::vector<int> winners;
+};
+
+}
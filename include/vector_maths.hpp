@@ -6,7 +6,8 @@
 
 namespace ash {
 
-inline constexpr double clamp(double x, double lo, double hi) {
+template<class Scalar>
+inline constexpr Scalar clamp(Scalar x, Scalar lo, Scalar hi) {
     if (x < lo) {
         x = lo;
     }
@@ -17,93 +18,110 @@ inline constexpr double clamp(double x, double lo, double hi) {
 
 }
 
-struct Vector_2d {
-    double x;
-    double y;
+// The physics runs in single or double precision: everything that stores
+// coordinates is templated on the scalar type, and the usual names
+// (Vector_2d, AABB, Body, Environment...) are the double instantiations.
+template<class Scalar_type>
+struct Basic_vector_2d {
+    typedef Scalar_type Scalar;
 
-    constexpr Vector_2d(double x = 0, double y = 0) : x(x), y(y) {}
+    Scalar x;
+    Scalar y;
+
+    constexpr Basic_vector_2d(Scalar x = 0, Scalar y = 0) : x(x), y(y) {}
+
+    template<class Other>
+    explicit constexpr Basic_vector_2d(const Basic_vector_2d<Other>& other) :
+        x(static_cast<Scalar>(other.x)), y(static_cast<Scalar>(other.y)) {}
 
     constexpr bool is_zero() const {
         return x==0 && y==0;
     }
 
-    constexpr bool operator==(const Vector_2d& other) const {
+    constexpr bool operator==(const Basic_vector_2d& other) const {
         return x==other.x && y==other.y;
     }
 
-    constexpr bool operator!=(const Vector_2d& other) const {
+    constexpr bool operator!=(const Basic_vector_2d& other) const {
         return x!=other.x && y!=other.y;
     }
 
-    constexpr Vector_2d operator+(const Vector_2d& other) const {
-        return Vector_2d{x+other.x, y+other.y};
+    constexpr Basic_vector_2d operator+(const Basic_vector_2d& other) const {
+        return Basic_vector_2d{x+other.x, y+other.y};
     }
 
-    Vector_2d& operator+=(const Vector_2d& other) {
+    Basic_vector_2d& operator+=(const Basic_vector_2d& other) {
         x += other.x;
         y += other.y;
         return *this;
     }
 
-    constexpr Vector_2d operator-(const Vector_2d& other) const {
-        return Vector_2d(x-other.x, y-other.y);
+    constexpr Basic_vector_2d operator-(const Basic_vector_2d& other) const {
+        return Basic_vector_2d(x-other.x, y-other.y);
     }
 
-    constexpr Vector_2d operator-() const {
-        return Vector_2d(-x,-y);
+    constexpr Basic_vector_2d operator-() const {
+        return Basic_vector_2d(-x,-y);
     }
 
-    Vector_2d& operator-=(const Vector_2d& other) {
+    Basic_vector_2d& operator-=(const Basic_vector_2d& other) {
         x -= other.x;
         y -= other.y;
         return *this;
     }
 
-    constexpr Vector_2d operator*(double s) const {
-        return Vector_2d(x*s, y*s);
+    constexpr Basic_vector_2d operator*(Scalar s) const {
+        return Basic_vector_2d(x*s, y*s);
     }
 
-    Vector_2d& operator*=(double s) {
+    Basic_vector_2d& operator*=(Scalar s) {
         x *= s;
         y *= s;
         return *this;
     }
 
-    constexpr Vector_2d operator/(double s) const {
-        return Vector_2d{x/s, y/s};
+    constexpr Basic_vector_2d operator/(Scalar s) const {
+        return Basic_vector_2d{x/s, y/s};
     }
 
-    Vector_2d& operator/=(double s) {
+    Basic_vector_2d& operator/=(Scalar s) {
         x /= s;
         y /= s;
         return *this;
     }
 
-    constexpr double norm_sq() const {
+    constexpr Scalar norm_sq() const {
         return x*x + y*y;
     }
 
-    constexpr double norm() const {
+    constexpr Scalar norm() const {
+        using std::sqrt;
         return sqrt(norm_sq());
     }
 
-    constexpr Vector_2d normalize() const {
+    constexpr Basic_vector_2d normalize() const {
         return (*this) / norm();
     }
 
-    constexpr double dot(const Vector_2d& other) {
+    constexpr Scalar dot(const Basic_vector_2d& other) const {
         return x*other.x + y*other.y;
     }
 
-    constexpr double angle(const Vector_2d& other) {
+    constexpr Scalar angle(const Basic_vector_2d& other) const {
+        using std::acos;
         return acos(dot(other) / (norm()*other.norm()));
-    } 
+    }
+
+    friend constexpr Basic_vector_2d operator*(Scalar s,
+            const Basic_vector_2d& v) {
+        return v*s;
+    }
 };
 
-inline constexpr Vector_2d operator*(double s, const Vector_2d& v) {
-    return v*s;
-}
+typedef Basic_vector_2d<double> Vector_2d;
+typedef Basic_vector_2d<float> Vector_2f;
 
-std::ostream& operator<<(std::ostream& out, const Vector_2d& v);
+template<class Scalar>
+std::ostream& operator<<(std::ostream& out, const Basic_vector_2d<Scalar>& v);
 
 }
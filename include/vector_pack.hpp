@@ -0,0 +1,495 @@
+#pragma once
+
+#include "vector_maths.hpp"
+
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+
+namespace ash {
+
+// Lanes doubles handled as one. The widths the target of the build has
+// registers for (2 with SSE2, 4 with AVX, 8 with AVX-512F) are backed by a
+// register and its intrinsics, the others by a loop over the lanes. Every
+// lane goes through the same IEEE operations as the scalar code, so the
+// results are the same bit for bit as long as the compiler does not fuse
+// multiplications and additions (it cannot in the default build, which
+// targets plain x86-64).
+template<size_t Lanes>
+struct Double_pack {
+    static constexpr size_t lanes = Lanes;
+
+    // the outcome of a comparison, lane by lane
+    struct Mask {
+        bool v[Lanes];
+
+        // bit i set if lane i is
+        unsigned get_bits() const {
+            unsigned out = 0;
+            for (size_t i = 0; i < Lanes; ++i) {
+                out |= unsigned(v[i]) << i;
+            }
+            return out;
+        }
+
+#define ASH_MASK_OPERATOR(op) \
+        friend Mask operator op(const Mask& a, const Mask& b) { \
+            Mask out; \
+            for (size_t i = 0; i < Lanes; ++i) { \
+                out.v[i] = a.v[i] op b.v[i]; \
+            } \
+            return out; \
+        }
+
+        ASH_MASK_OPERATOR(&)
+        ASH_MASK_OPERATOR(|)
+
+#undef ASH_MASK_OPERATOR
+
+        friend Mask operator!(const Mask& a) {
+            Mask out;
+            for (size_t i = 0; i < Lanes; ++i) {
+                out.v[i] = !a.v[i];
+            }
+            return out;
+        }
+    };
+
+    double v[Lanes];
+
+    static Double_pack broadcast(double x) {
+        Double_pack out;
+        for (size_t i = 0; i < Lanes; ++i) {
+            out.v[i] = x;
+        }
+        return out;
+    }
+
+    static Double_pack load(const double* p) {
+        Double_pack out;
+        for (size_t i = 0; i < Lanes; ++i) {
+            out.v[i] = p[i];
+        }
+        return out;
+    }
+
+    void store(double* p) const {
+        for (size_t i = 0; i < Lanes; ++i) {
+            p[i] = v[i];
+        }
+    }
+
+    double get(size_t i) const {
+        return v[i];
+    }
+
+    void set(size_t i, double x) {
+        v[i] = x;
+    }
+
+#define ASH_PACK_OPERATOR(op) \
+    friend Double_pack operator op(const Double_pack& a, \
+            const Double_pack& b) { \
+        Double_pack out; \
+        for (size_t i = 0; i < Lanes; ++i) { \
+            out.v[i] = a.v[i] op b.v[i]; \
+        } \
+        return out; \
+    }
+
+    ASH_PACK_OPERATOR(+)
+    ASH_PACK_OPERATOR(-)
+    ASH_PACK_OPERATOR(*)
+    ASH_PACK_OPERATOR(/)
+
+#undef ASH_PACK_OPERATOR
+
+#define ASH_PACK_COMPARISON(op) \
+    friend Mask operator op(const Double_pack& a, const Double_pack& b) { \
+        Mask out; \
+        for (size_t i = 0; i < Lanes; ++i) { \
+            out.v[i] = a.v[i] op b.v[i]; \
+        } \
+        return out; \
+    }
+
+    ASH_PACK_COMPARISON(<)
+    ASH_PACK_COMPARISON(>)
+    ASH_PACK_COMPARISON(==)
+
+#undef ASH_PACK_COMPARISON
+
+    friend Double_pack sqrt(const Double_pack& a) {
+        Double_pack out;
+        for (size_t i = 0; i < Lanes; ++i) {
+            out.v[i] = std::sqrt(a.v[i]);
+        }
+        return out;
+    }
+
+    // a where mask is set, b elsewhere
+    friend Double_pack select(const Mask& mask, const Double_pack& a,
+            const Double_pack& b) {
+        Double_pack out;
+        for (size_t i = 0; i < Lanes; ++i) {
+            out.v[i] = mask.v[i]? a.v[i] : b.v[i];
+        }
+        return out;
+    }
+};
+
+#if defined(__SSE2__)
+
+// What the specializations below need besides the arithmetic, overloaded
+// on the register: comparisons to a mask register (a register of all ones
+// or all zeros per lane up to AVX2, a bit per lane with AVX-512), the
+// logic of masks and blending.
+namespace pack_detail {
+
+inline __m128d less(__m128d a, __m128d b) {
+    return _mm_cmplt_pd(a, b);
+}
+
+inline __m128d greater(__m128d a, __m128d b) {
+    return _mm_cmpgt_pd(a, b);
+}
+
+inline __m128d equal(__m128d a, __m128d b) {
+    return _mm_cmpeq_pd(a, b);
+}
+
+inline __m128d mask_and(__m128d a, __m128d b) {
+    return _mm_and_pd(a, b);
+}
+
+inline __m128d mask_or(__m128d a, __m128d b) {
+    return _mm_or_pd(a, b);
+}
+
+inline __m128d mask_not(__m128d a) {
+    return _mm_xor_pd(a, _mm_castsi128_pd(_mm_set1_epi32(-1)));
+}
+
+inline unsigned get_bits(__m128d mask) {
+    return _mm_movemask_pd(mask);
+}
+
+// no blend before SSE4.1
+inline __m128d select(__m128d mask, __m128d a, __m128d b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+#if defined(__AVX__)
+
+inline __m256d less(__m256d a, __m256d b) {
+    return _mm256_cmp_pd(a, b, _CMP_LT_OQ);
+}
+
+inline __m256d greater(__m256d a, __m256d b) {
+    return _mm256_cmp_pd(a, b, _CMP_GT_OQ);
+}
+
+inline __m256d equal(__m256d a, __m256d b) {
+    return _mm256_cmp_pd(a, b, _CMP_EQ_OQ);
+}
+
+inline __m256d mask_and(__m256d a, __m256d b) {
+    return _mm256_and_pd(a, b);
+}
+
+inline __m256d mask_or(__m256d a, __m256d b) {
+    return _mm256_or_pd(a, b);
+}
+
+inline __m256d mask_not(__m256d a) {
+    return _mm256_xor_pd(a, _mm256_castsi256_pd(_mm256_set1_epi32(-1)));
+}
+
+inline unsigned get_bits(__m256d mask) {
+    return _mm256_movemask_pd(mask);
+}
+
+inline __m256d select(__m256d mask, __m256d a, __m256d b) {
+    return _mm256_blendv_pd(b, a, mask);
+}
+
+#endif
+
+#if defined(__AVX512F__)
+
+inline __mmask8 less(__m512d a, __m512d b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ);
+}
+
+inline __mmask8 greater(__m512d a, __m512d b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ);
+}
+
+inline __mmask8 equal(__m512d a, __m512d b) {
+    return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ);
+}
+
+inline __mmask8 mask_and(__mmask8 a, __mmask8 b) {
+    return a & b;
+}
+
+inline __mmask8 mask_or(__mmask8 a, __mmask8 b) {
+    return a | b;
+}
+
+inline __mmask8 mask_not(__mmask8 a) {
+    return ~a;
+}
+
+inline unsigned get_bits(__mmask8 mask) {
+    return mask;
+}
+
+inline __m512d select(__mmask8 mask, __m512d a, __m512d b) {
+    return _mm512_mask_blend_pd(mask, b, a);
+}
+
+#endif
+
+}
+
+#endif
+
+// The specializations below wrap one register. Loads and stores need no
+// alignment.
+#define ASH_REGISTER_PACK(Lanes, Register, suffix) \
+template<> \
+struct Double_pack<Lanes> { \
+    static constexpr size_t lanes = Lanes; \
+    \
+    struct Mask { \
+        decltype(pack_detail::less(Register(), Register())) m; \
+        \
+        unsigned get_bits() const { \
+            return pack_detail::get_bits(m); \
+        } \
+        \
+        friend Mask operator&(const Mask& a, const Mask& b) { \
+            return {pack_detail::mask_and(a.m, b.m)}; \
+        } \
+        \
+        friend Mask operator|(const Mask& a, const Mask& b) { \
+            return {pack_detail::mask_or(a.m, b.m)}; \
+        } \
+        \
+        friend Mask operator!(const Mask& a) { \
+            return {pack_detail::mask_not(a.m)}; \
+        } \
+    }; \
+    \
+    Register v; \
+    \
+    static Double_pack broadcast(double x) { \
+        return {_mm##suffix##_set1_pd(x)}; \
+    } \
+    \
+    static Double_pack load(const double* p) { \
+        return {_mm##suffix##_loadu_pd(p)}; \
+    } \
+    \
+    void store(double* p) const { \
+        _mm##suffix##_storeu_pd(p, v); \
+    } \
+    \
+    double get(size_t i) const { \
+        double lanes[Lanes]; \
+        store(lanes); \
+        return lanes[i]; \
+    } \
+    \
+    void set(size_t i, double x) { \
+        double lanes[Lanes]; \
+        store(lanes); \
+        lanes[i] = x; \
+        *this = load(lanes); \
+    } \
+    \
+    friend Double_pack operator+(const Double_pack& a, \
+            const Double_pack& b) { \
+        return {_mm##suffix##_add_pd(a.v, b.v)}; \
+    } \
+    \
+    friend Double_pack operator-(const Double_pack& a, \
+            const Double_pack& b) { \
+        return {_mm##suffix##_sub_pd(a.v, b.v)}; \
+    } \
+    \
+    friend Double_pack operator*(const Double_pack& a, \
+            const Double_pack& b) { \
+        return {_mm##suffix##_mul_pd(a.v, b.v)}; \
+    } \
+    \
+    friend Double_pack operator/(const Double_pack& a, \
+            const Double_pack& b) { \
+        return {_mm##suffix##_div_pd(a.v, b.v)}; \
+    } \
+    \
+    friend Double_pack sqrt(const Double_pack& a) { \
+        return {_mm##suffix##_sqrt_pd(a.v)}; \
+    } \
+    \
+    friend Mask operator<(const Double_pack& a, const Double_pack& b) { \
+        return {pack_detail::less(a.v, b.v)}; \
+    } \
+    \
+    friend Mask operator>(const Double_pack& a, const Double_pack& b) { \
+        return {pack_detail::greater(a.v, b.v)}; \
+    } \
+    \
+    friend Mask operator==(const Double_pack& a, const Double_pack& b) { \
+        return {pack_detail::equal(a.v, b.v)}; \
+    } \
+    \
+    friend Double_pack select(const Mask& mask, const Double_pack& a, \
+            const Double_pack& b) { \
+        return {pack_detail::select(mask.m, a.v, b.v)}; \
+    } \
+};
+
+#if defined(__SSE2__)
+ASH_REGISTER_PACK(2, __m128d, )
+#endif
+#if defined(__AVX__)
+ASH_REGISTER_PACK(4, __m256d, 256)
+#endif
+#if defined(__AVX512F__)
+ASH_REGISTER_PACK(8, __m512d, 512)
+#endif
+
+#undef ASH_REGISTER_PACK
+
+// the widest pack backed by a register in this build
+#if defined(__AVX512F__)
+constexpr size_t native_lanes = 8;
+#elif defined(__AVX__)
+constexpr size_t native_lanes = 4;
+#elif defined(__SSE2__)
+constexpr size_t native_lanes = 2;
+#else
+constexpr size_t native_lanes = 1;
+#endif
+
+// Lanes vectors in structure of arrays form: the x of every lane, then the
+// y. The operations mirror those of Vector_2d, lane by lane.
+template<size_t Lanes>
+struct Vector_2d_pack {
+    typedef Double_pack<Lanes> Pack;
+    typedef typename Pack::Mask Mask;
+
+    static constexpr size_t lanes = Lanes;
+
+    Pack x;
+    Pack y;
+
+    static Vector_2d_pack broadcast(const Vector_2d& v) {
+        return {Pack::broadcast(v.x), Pack::broadcast(v.y)};
+    }
+
+    // from separate arrays of x and y
+    static Vector_2d_pack load(const double* x, const double* y) {
+        return {Pack::load(x), Pack::load(y)};
+    }
+
+    void store(double* x, double* y) const {
+        this->x.store(x);
+        this->y.store(y);
+    }
+
+    Vector_2d get(size_t i) const {
+        return Vector_2d(x.get(i), y.get(i));
+    }
+
+    void set(size_t i, const Vector_2d& v) {
+        x.set(i, v.x);
+        y.set(i, v.y);
+    }
+
+    friend Vector_2d_pack operator+(const Vector_2d_pack& a,
+            const Vector_2d_pack& b) {
+        return {a.x + b.x, a.y + b.y};
+    }
+
+    friend Vector_2d_pack operator-(const Vector_2d_pack& a,
+            const Vector_2d_pack& b) {
+        return {a.x - b.x, a.y - b.y};
+    }
+
+    friend Vector_2d_pack operator*(const Vector_2d_pack& v, const Pack& s) {
+        return {v.x*s, v.y*s};
+    }
+
+    friend Vector_2d_pack operator*(const Pack& s, const Vector_2d_pack& v) {
+        return v*s;
+    }
+
+    friend Vector_2d_pack operator/(const Vector_2d_pack& v, const Pack& s) {
+        return {v.x/s, v.y/s};
+    }
+
+    Pack dot(const Vector_2d_pack& other) const {
+        return x*other.x + y*other.y;
+    }
+
+    Pack norm_sq() const {
+        return x*x + y*y;
+    }
+
+    Pack norm() const {
+        return sqrt(norm_sq());
+    }
+
+    Vector_2d_pack normalize() const {
+        return *this/norm();
+    }
+
+    friend Vector_2d_pack select(const Mask& mask, const Vector_2d_pack& a,
+            const Vector_2d_pack& b) {
+        return {select(mask, a.x, b.x), select(mask, a.y, b.y)};
+    }
+};
+
+typedef Vector_2d_pack<2> Vector_2d_x2;
+typedef Vector_2d_pack<4> Vector_2d_x4;
+typedef Vector_2d_pack<8> Vector_2d_x8;
+
+// Instruction sets of the batched kernels below, narrowest first
+enum class Simd_isa {scalar, sse2, avx2, avx512};
+
+const char* get_name(Simd_isa isa);
+
+// whether both the compiler and the CPU the program runs on support it
+bool is_supported(Simd_isa isa);
+
+// Batched operations on n vectors stored as separate arrays of x and y.
+// There is an implementation per instruction set, compiled for it whatever
+// the target of the build, and all of them give the same results, bit for
+// bit, as Vector_2d. Outputs may alias inputs.
+struct Simd_kernels {
+    Simd_isa isa;
+
+    void (*norm)(const double* x, const double* y, double* out, size_t n);
+
+    void (*normalize)(const double* x, const double* y, double* out_x,
+            double* out_y, size_t n);
+
+    void (*dot)(const double* x1, const double* y1, const double* x2,
+            const double* y2, double* out, size_t n);
+};
+
+// the kernels of an instruction set, which must be supported
+const Simd_kernels& get_simd_kernels(Simd_isa isa);
+
+// the kernels of the widest instruction set supported, picked once at the
+// first call
+const Simd_kernels& get_simd_kernels();
+
+}
@@ -0,0 +1,156 @@
+#include "physics.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef ash::Environment::State State;
+typedef ash::Environment::Action Action;
+typedef ash::Environment::Integrator Integrator;
+
+// ticks simulated from every initial state
+constexpr size_t horizon = 10;
+
+struct Scenario {
+    State state;
+    Action actions[2];
+};
+
+std::vector<Scenario> make_scenarios(size_t count) {
+    using namespace ::ash::parameters;
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> x(
+            mallet_radius, field_length/2 - mallet_radius);
+    std::uniform_real_distribution<double> y(
+            -field_width/2 + mallet_radius, field_width/2 - mallet_radius);
+    std::uniform_real_distribution<double> v(-2, 2);
+    std::vector<Scenario> scenarios(count);
+    for (auto& scenario : scenarios) {
+        for (size_t i = 0; i < 2; ++i) {
+            double side = i == 0? -1 : 1;
+            scenario.state.mallets[i].position = ash::Vector_2d(
+                    side*x(rng), y(rng));
+            scenario.state.mallets[i].velocity = ash::Vector_2d(
+                    v(rng), v(rng));
+            scenario.actions[i] = ash::Vector_2d(side*x(rng), y(rng));
+        }
+        scenario.state.puck.position = ash::Vector_2d(
+                (x(rng) - field_length/4)*1.5, y(rng));
+        scenario.state.puck.velocity = ash::Vector_2d(v(rng), v(rng));
+    }
+    return scenarios;
+}
+
+State run(ash::Environment& env, const Scenario& scenario) {
+    env.set_state(scenario.state);
+    for (size_t t = 0; t < horizon; ++t) {
+        if (env.step(scenario.actions[0], scenario.actions[1]) != -1) {
+            break;
+        }
+    }
+    return env.get_state();
+}
+
+double distance(const State& a, const State& b) {
+    double out = (a.puck.position - b.puck.position).norm();
+    for (size_t i = 0; i < 2; ++i) {
+        out = std::max(out,
+                (a.mallets[i].position - b.mallets[i].position).norm());
+    }
+    return out;
+}
+
+const char* name(Integrator integrator) {
+    switch (integrator) {
+        case Integrator::semi_implicit_euler:
+            return "semi-implicit Euler";
+        case Integrator::velocity_verlet:
+            return "velocity Verlet";
+        case Integrator::runge_kutta:
+            return "Runge-Kutta 4";
+    }
+    return "";
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    // accuracy target, as the median position error after the horizon
+    double target = (argc > 1? std::stod(argv[1]) : 1.0)*1e-3;
+    size_t count = argc > 2? std::stoul(argv[2]) : 2000;
+    auto scenarios = make_scenarios(count);
+
+    // very fine steps with the most accurate integrator
+    std::vector<State> reference;
+    {
+        ash::Environment env;
+        env.set_integrator(Integrator::runge_kutta);
+        env.set_fixed_substeps(1000);
+        for (const auto& scenario : scenarios) {
+            reference.push_back(run(env, scenario));
+        }
+    }
+
+    std::cout << count << " scenarios of " << horizon << " ticks, "
+              << "reference: Runge-Kutta 4 with 1000 substeps" << std::endl;
+    std::cout << std::setw(22) << "integrator"
+              << std::setw(10) << "substeps"
+              << std::setw(16) << "median err (mm)"
+              << std::setw(14) << "mean err (mm)"
+              << std::setw(10) << "ns/tick" << std::endl;
+    const char* best = nullptr;
+    int best_substeps = 0;
+    double best_cost = ash::inf;
+    for (auto integrator : {Integrator::semi_implicit_euler,
+            Integrator::velocity_verlet, Integrator::runge_kutta}) {
+        for (int substeps : {1, 2, 4, 10, 20}) {
+            ash::Environment env;
+            env.set_integrator(integrator);
+            env.set_fixed_substeps(substeps);
+            std::vector<double> errors;
+            auto start = Clock::now();
+            for (size_t i = 0; i < scenarios.size(); ++i) {
+                errors.push_back(distance(run(env, scenarios[i]),
+                            reference[i]));
+            }
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            double cost = elapsed.count()/(scenarios.size()*horizon)*1e9;
+            double mean = 0;
+            for (double error : errors) {
+                mean += error;
+            }
+            mean /= errors.size();
+            std::nth_element(errors.begin(),
+                    errors.begin() + errors.size()/2, errors.end());
+            double median = errors[errors.size()/2];
+            if (median <= target && cost < best_cost) {
+                best = name(integrator);
+                best_substeps = substeps;
+                best_cost = cost;
+            }
+            std::cout << std::fixed
+                      << std::setw(22) << name(integrator)
+                      << std::setw(10) << substeps
+                      << std::setw(16) << std::setprecision(4) << median*1e3
+                      << std::setw(14) << mean*1e3
+                      << std::setw(10) << std::setprecision(0) << cost
+                      << std::endl;
+        }
+    }
+    std::cout << "Cheapest within " << target*1e3 << " mm: ";
+    if (best) {
+        std::cout << best << " with " << best_substeps << " substeps";
+    }
+    else {
+        std::cout << "none";
+    }
+    std::cout << std::endl;
+}
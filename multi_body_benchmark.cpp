@@ -0,0 +1,173 @@
+#include "multi_environment.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef ash::Multi_environment::Broadphase Broadphase;
+
+// A table grown with the number of bodies, so that they cover the same
+// share of it whatever their number: a third of them mallets, split
+// between both halves, and the rest pucks, all on a jittered grid.
+struct Setup {
+    ash::Parameter_set parameters;
+    std::vector<ash::Vector_2d> mallets;
+    std::vector<ash::Vector_2d> pucks;
+    std::vector<ash::Vector_2d> puck_velocities;
+};
+
+Setup make_setup(size_t bodies) {
+    using namespace ::ash::parameters;
+    Setup setup;
+    setup.parameters = ash::default_parameters;
+    // the standard table holds three bodies
+    double scale = std::sqrt(std::max(bodies, size_t(3))/3.0);
+    setup.parameters.field_length *= scale;
+    setup.parameters.field_width *= scale;
+    setup.parameters.goal_width *= scale;
+    auto& config = setup.parameters;
+
+    std::mt19937 rng(bodies);
+    std::uniform_real_distribution<double> jitter(-0.01, 0.01);
+    std::uniform_real_distribution<double> speed(-2, 2);
+    // cells of 0.14 m, which any body fits in
+    constexpr double cell = 0.14;
+    size_t columns = static_cast<size_t>(config.field_length/cell);
+    size_t rows = static_cast<size_t>(config.field_width/cell);
+    size_t mallet_count = std::max<size_t>(2, bodies/3) & ~size_t(1);
+    std::vector<ash::Vector_2d> cells;
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < columns; ++j) {
+            // keep the column of the centre line free
+            if (columns % 2 == 1 && j == columns/2) {
+                continue;
+            }
+            cells.emplace_back(-config.field_length/2 + (j + 0.5)*cell,
+                    -config.field_width/2 + (i + 0.5)*cell);
+        }
+    }
+    std::shuffle(cells.begin(), cells.end(), rng);
+    for (const auto& position : cells) {
+        auto jittered = position + ash::Vector_2d(jitter(rng), jitter(rng));
+        bool left = position.x < 0;
+        size_t side_count = 0;
+        for (const auto& mallet : setup.mallets) {
+            side_count += (mallet.x < 0) == left;
+        }
+        if (setup.mallets.size() < mallet_count &&
+                side_count < mallet_count/2 &&
+                std::abs(position.x) > mallet_radius + wall_thickness) {
+            setup.mallets.push_back(jittered);
+        }
+        else if (setup.pucks.size() + mallet_count < bodies) {
+            setup.pucks.push_back(jittered);
+            setup.puck_velocities.emplace_back(speed(rng), speed(rng));
+        }
+    }
+    return setup;
+}
+
+ash::Multi_environment make_table(const Setup& setup, Broadphase broadphase) {
+    ash::Multi_environment env(setup.parameters);
+    env.set_broadphase(broadphase);
+    for (const auto& position : setup.mallets) {
+        env.add_mallet(position);
+    }
+    for (size_t i = 0; i < setup.pucks.size(); ++i) {
+        env.add_puck(setup.pucks[i], setup.puck_velocities[i]);
+    }
+    return env;
+}
+
+// every mallet chases a random spot in its half, changed every 25 ticks
+std::vector<std::vector<ash::Vector_2d>> make_actions(const Setup& setup,
+        size_t ticks) {
+    const auto& config = setup.parameters;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> x(0.1, config.field_length/2);
+    std::uniform_real_distribution<double> y(-config.field_width/2,
+            config.field_width/2);
+    std::vector<std::vector<ash::Vector_2d>> actions(ticks);
+    std::vector<ash::Vector_2d> targets = setup.mallets;
+    for (size_t t = 0; t < ticks; ++t) {
+        if (t % 25 == 0) {
+            for (size_t i = 0; i < targets.size(); ++i) {
+                double side = setup.mallets[i].x < 0? -1 : 1;
+                targets[i] = ash::Vector_2d(side*x(rng), y(rng));
+            }
+        }
+        actions[t] = targets;
+    }
+    return actions;
+}
+
+struct Result {
+    double step_seconds;
+    double pair_tests;
+    std::uint64_t hash;
+    int goals;
+};
+
+Result run(const Setup& setup, Broadphase broadphase,
+        const std::vector<std::vector<ash::Vector_2d>>& actions) {
+    auto env = make_table(setup, broadphase);
+    Result result = {0, 0, 0, 0};
+    auto start = Clock::now();
+    for (const auto& tick : actions) {
+        auto goals = env.step(tick);
+        result.goals += goals[0] + goals[1];
+        result.pair_tests += env.get_last_pair_tests();
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    result.step_seconds = elapsed.count()/actions.size();
+    result.pair_tests /= actions.size()*setup.parameters.substeps;
+    result.hash = env.get_state_hash();
+    return result;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t ticks = argc > 1? std::stoul(argv[1]) : 100;
+    // the brute force broadphase is quadratic: not beyond this
+    size_t brute_force_limit = argc > 2? std::stoul(argv[2]) : 1536;
+    std::cout << ticks << " ticks" << std::endl;
+    std::cout << std::setw(7) << "bodies"
+              << std::setw(9) << "mallets"
+              << std::setw(13) << "pairs/subst"
+              << std::setw(14) << "sap us/step"
+              << std::setw(16) << "sap ns/body"
+              << std::setw(16) << "brute us/step"
+              << std::setw(8) << "same" << std::endl;
+    bool all_same = true;
+    for (size_t bodies : {3, 6, 12, 24, 48, 96, 192, 384, 768, 1536, 3072,
+            6144}) {
+        auto setup = make_setup(bodies);
+        auto actions = make_actions(setup, ticks);
+        size_t count = setup.mallets.size() + setup.pucks.size();
+        auto sap = run(setup, Broadphase::sweep_and_prune, actions);
+        std::cout << std::setw(7) << count
+                  << std::setw(9) << setup.mallets.size()
+                  << std::fixed << std::setprecision(1)
+                  << std::setw(13) << sap.pair_tests
+                  << std::setw(14) << sap.step_seconds*1e6
+                  << std::setw(16) << sap.step_seconds*1e9/count;
+        if (bodies <= brute_force_limit) {
+            auto brute = run(setup, Broadphase::brute_force, actions);
+            bool same = brute.hash == sap.hash && brute.goals == sap.goals;
+            all_same = all_same && same;
+            std::cout << std::setw(16) << brute.step_seconds*1e6
+                      << std::setw(8) << (same? "yes" : "NO");
+        }
+        std::cout << std::defaultfloat << std::endl;
+    }
+    return all_same? 0 : 1;
+}
@@ -0,0 +1,253 @@
+#include "multi_environment.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+
+namespace {
+
+// the controller of Environment
+ash::Vector_2d pd_control(const ash::Parameter_set& config,
+        const ash::Vector_2d& target, const ash::Disk& mallet) {
+    const double max_p_force = config.kd*config.mallet_max_velocity;
+    auto p = config.kp*(target - mallet.get_position());
+    auto p_mag_sq = p.norm_sq();
+    if (p_mag_sq > max_p_force*max_p_force) {
+        p = max_p_force/std::sqrt(p_mag_sq) * p;
+    }
+    return p - config.kd*mallet.get_velocity();
+}
+
+void collide(ash::Box wall, ash::Disk& disk, const ash::Parameter_set& config,
+        double restitution) {
+    if (!ash::broadphase_test(wall, disk)) {
+        return;
+    }
+    if (auto collision = ash::collides(wall, disk)) {
+        ash::resolve_collision(*collision, restitution);
+        ash::correct_position(*collision, config.slop,
+                config.positional_correction);
+    }
+}
+
+}
+
+
+ash::Multi_environment::Multi_environment(const Parameter_set& parameters) :
+    parameters(parameters),
+    rink(&Runtime_environment(parameters).get_rink()),
+    broadphase(Broadphase::sweep_and_prune),
+    order_stale(true),
+    last_pair_tests(0)
+{
+}
+
+size_t ash::Multi_environment::add_mallet(const Vector_2d& position) {
+    // numbered before the pucks
+    Disk mallet(parameters.mallet_radius, parameters.mallet_mass);
+    mallet.set_position(position);
+    mallet.set_velocity(Vector_2d(0, 0));
+    mallets.push_back(mallet);
+    order_stale = true;
+    return mallets.size() - 1;
+}
+
+size_t ash::Multi_environment::add_puck(const Vector_2d& position,
+        const Vector_2d& velocity) {
+    Disk puck(parameters.puck_radius, parameters.puck_mass);
+    puck.set_position(position);
+    puck.set_velocity(velocity);
+    pucks.push_back(puck);
+    order_stale = true;
+    return pucks.size() - 1;
+}
+
+std::array<int,2> ash::Multi_environment::step(
+        const std::vector<Action>& actions) {
+    double h = parameters.substep_dt();
+    last_pair_tests = 0;
+    for (int i = 0; i < parameters.substeps; ++i) {
+        integrate(actions, h);
+        collide_with_rink();
+        if (broadphase == Broadphase::sweep_and_prune) {
+            find_pairs_sweep_and_prune();
+        }
+        else {
+            find_pairs_brute_force();
+        }
+        last_pair_tests += pairs.size();
+        collide_pairs();
+    }
+
+    // as Environment::check_goal
+    std::array<int,2> goals = {0, 0};
+    double goal_threshold = parameters.field_length/2 + parameters.puck_radius;
+    auto scored = [&](const Disk& puck) {
+        double x = puck.get_position().x;
+        if (x > goal_threshold) {
+            ++goals[0];
+            return true;
+        }
+        if (x < -goal_threshold) {
+            ++goals[1];
+            return true;
+        }
+        return false;
+    };
+    auto end = std::remove_if(pucks.begin(), pucks.end(), scored);
+    if (end != pucks.end()) {
+        pucks.erase(end, pucks.end());
+        order_stale = true;
+    }
+    return goals;
+}
+
+std::uint64_t ash::Multi_environment::get_state_hash() const {
+    std::uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](double x) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &x, sizeof(x));
+        for (int i = 0; i < 8; ++i) {
+            hash ^= (bits >> (8*i)) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    };
+    for (const auto* bodies : {&mallets, &pucks}) {
+        for (const auto& body : *bodies) {
+            add(body.get_position().x);
+            add(body.get_position().y);
+            add(body.get_velocity().x);
+            add(body.get_velocity().y);
+        }
+    }
+    return hash;
+}
+
+void ash::Multi_environment::integrate(const std::vector<Action>& actions,
+        double h) {
+    // semi-implicit Euler, as Environment::integrate
+    for (size_t i = 0; i < mallets.size(); ++i) {
+        auto& mallet = mallets[i];
+        auto velocity = mallet.get_velocity() + pd_control(parameters,
+                actions[i], mallet)*mallet.get_inv_mass()*h;
+        mallet.set_velocity(velocity);
+        mallet.set_position(mallet.get_position() + velocity*h);
+    }
+    const double deceleration = parameters.gravity*parameters.puck_mu*h;
+    for (auto& puck : pucks) {
+        auto velocity = puck.get_velocity();
+        double velocity_mag = velocity.norm();
+        if (velocity_mag > 0) {
+            double velocity_dec = std::fmin(velocity_mag, deceleration);
+            velocity -= velocity_dec/velocity_mag * velocity;
+        }
+        puck.set_velocity(velocity);
+        puck.set_position(puck.get_position() + velocity*h);
+    }
+}
+
+void ash::Multi_environment::collide_with_rink() {
+    // The rink is only a handful of boxes, so every body is tested against
+    // all of them (in the order of Environment).
+    for (auto& mallet : mallets) {
+        for (const auto& wall : rink->walls) {
+            collide(wall, mallet, parameters,
+                    parameters.mallet_wall_restitution);
+        }
+        for (const auto& barrier : rink->barriers) {
+            collide(barrier, mallet, parameters,
+                    parameters.mallet_wall_restitution);
+        }
+    }
+    for (auto& puck : pucks) {
+        for (const auto& wall : rink->walls) {
+            collide(wall, puck, parameters,
+                    parameters.puck_wall_restitution);
+        }
+    }
+}
+
+void ash::Multi_environment::find_pairs_brute_force() {
+    size_t count = mallets.size() + pucks.size();
+    boxes.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        boxes[i] = get_body(i).get_bounding_box();
+    }
+    pairs.clear();
+    for (size_t i = 0; i < count; ++i) {
+        for (size_t j = i + 1; j < count; ++j) {
+            if (boxes[i].intersects(boxes[j])) {
+                pairs.push_back({static_cast<std::uint32_t>(i),
+                        static_cast<std::uint32_t>(j)});
+            }
+        }
+    }
+}
+
+void ash::Multi_environment::find_pairs_sweep_and_prune() {
+    size_t count = mallets.size() + pucks.size();
+    boxes.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        boxes[i] = get_body(i).get_bounding_box();
+    }
+    auto by_left_edge = [this](std::uint32_t i, std::uint32_t j) {
+        return boxes[i].x_min < boxes[j].x_min;
+    };
+    if (order_stale) {
+        order.resize(count);
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), by_left_edge);
+        order_stale = false;
+    }
+    else {
+        // bodies move little in a substep: the order of the previous one is
+        // nearly sorted, and insertion sort takes about one pass over it
+        for (size_t k = 1; k < count; ++k) {
+            auto body = order[k];
+            size_t m = k;
+            for (; m > 0 && by_left_edge(body, order[m - 1]); --m) {
+                order[m] = order[m - 1];
+            }
+            order[m] = body;
+        }
+    }
+
+    pairs.clear();
+    for (size_t k = 0; k < count; ++k) {
+        auto i = order[k];
+        const auto& box = boxes[i];
+        for (size_t m = k + 1; m < count && boxes[order[m]].x_min < box.x_max;
+                ++m) {
+            auto j = order[m];
+            if (box.intersects(boxes[j])) {
+                pairs.push_back({std::min(i, j), std::max(i, j)});
+            }
+        }
+    }
+    // the order of brute_force
+    std::sort(pairs.begin(), pairs.end(), [](const Pair& l, const Pair& r) {
+            return l.a < r.a || (l.a == r.a && l.b < r.b);
+        });
+}
+
+void ash::Multi_environment::collide_pairs() {
+    for (const auto& pair : pairs) {
+        auto& a = get_body(pair.a);
+        auto& b = get_body(pair.b);
+        auto collision = collides(a, b);
+        if (!collision) {
+            continue;
+        }
+        bool mallet_a = pair.a < mallets.size();
+        bool mallet_b = pair.b < mallets.size();
+        double restitution = mallet_a && mallet_b?
+            parameters.mallet_wall_restitution :
+            mallet_a || mallet_b? parameters.mallet_puck_restitution :
+            parameters.puck_wall_restitution;
+        resolve_collision(*collision, restitution);
+        correct_position(*collision, parameters.slop,
+                parameters.positional_correction);
+    }
+}
@@ -0,0 +1,200 @@
+#include "benchmark_support.hpp"
+#include "physics.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef ash::benchmark::Clock Clock;
+typedef ash::Environment::Static_collision Static_collision;
+
+using ash::benchmark::Random_player;
+using ash::benchmark::same_bits;
+
+// Mallets all over the rink and a little beyond, so that a good share of
+// them touches some wall or barrier.
+std::vector<ash::Disk> random_mallets(size_t count) {
+    using namespace ::ash::parameters;
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> x(-field_length/2 - 0.05,
+            field_length/2 + 0.05);
+    std::uniform_real_distribution<double> y(-field_width/2 - 0.05,
+            field_width/2 + 0.05);
+    std::vector<ash::Disk> out;
+    for (size_t i = 0; i < count; ++i) {
+        ash::Disk mallet(mallet_radius, mallet_mass);
+        mallet.set_position(ash::Vector_2d(x(rng), y(rng)));
+        out.push_back(mallet);
+    }
+    return out;
+}
+
+// One mallet against the walls and barriers: handle_collision's tests one
+// box at a time against Packed_boxes. Prints ns per mallet and returns
+// the number of mismatches.
+size_t run_kernels(size_t count) {
+    ash::Environment env;
+    const auto& rink = env.get_rink();
+    std::vector<ash::Box> boxes(rink.walls.begin(), rink.walls.end());
+    boxes.insert(boxes.end(), rink.barriers.begin(), rink.barriers.end());
+    std::vector<ash::AABB> bounding_boxes;
+    for (const auto& box : boxes) {
+        bounding_boxes.push_back(box.get_bounding_box());
+    }
+    ash::Packed_boxes packed(bounding_boxes);
+    auto mallets = random_mallets(count);
+
+    std::vector<ash::Packed_boxes::Contacts> scalar(count), batched(count);
+    auto test_boxes = [&] {
+        for (size_t m = 0; m < count; ++m) {
+            auto& out = scalar[m];
+            out.mask = 0;
+            for (size_t i = 0; i < boxes.size(); ++i) {
+                if (!ash::broadphase_test(boxes[i], mallets[m])) {
+                    continue;
+                }
+                if (auto collision = ash::collides(boxes[i], mallets[m])) {
+                    out.mask |= 1u << i;
+                    out.penetration[i] = collision->penetration;
+                    out.normal_x[i] = collision->normal.x;
+                    out.normal_y[i] = collision->normal.y;
+                }
+            }
+        }
+    };
+    auto test_packed = [&] {
+        for (size_t m = 0; m < count; ++m) {
+            packed.collide(mallets[m].get_position(),
+                    mallets[m].get_radius(), batched[m]);
+        }
+    };
+    auto measure = [count](auto test) {
+        constexpr int repeats = 200;
+        double best = 1e300;
+        for (int run = 0; run < 5; ++run) {
+            auto start = Clock::now();
+            for (int r = 0; r < repeats; ++r) {
+                test();
+            }
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            best = std::min(best, elapsed.count()/(repeats*count)*1e9);
+        }
+        return best;
+    };
+    double t_boxes = measure(test_boxes);
+    double t_packed = measure(test_packed);
+
+    size_t mismatches = 0;
+    size_t contacts = 0;
+    for (size_t m = 0; m < count; ++m) {
+        bool same = scalar[m].mask == batched[m].mask;
+        for (size_t i = 0; same && i < boxes.size(); ++i) {
+            if (scalar[m].mask & (1u << i)) {
+                same = same_bits(scalar[m].penetration[i],
+                        batched[m].penetration[i]) &&
+                    same_bits(scalar[m].normal_x[i], batched[m].normal_x[i]) &&
+                    same_bits(scalar[m].normal_y[i], batched[m].normal_y[i]);
+            }
+        }
+        mismatches += !same;
+        contacts += scalar[m].mask != 0;
+    }
+    std::cout << count << " mallets against " << boxes.size()
+              << " boxes, " << 100.0*contacts/count << "% in contact"
+              << std::endl
+              << std::fixed << std::setprecision(1)
+              << "  ns per mallet: boxes " << t_boxes << ", packed "
+              << t_packed << " (" << ash::native_lanes << " lanes), "
+              << mismatches << " mismatches" << std::endl
+              << std::defaultfloat;
+    return mismatches;
+}
+
+ash::Environment make_environment(Static_collision static_collision,
+        bool contact_cache) {
+    ash::Environment env;
+    // every substep goes through the narrow phase
+    env.set_fast_path(false);
+    env.set_contact_cache(contact_cache);
+    env.set_static_collision(static_collision);
+    return env;
+}
+
+// ns per substep of a random match
+double measure_match(Static_collision static_collision, bool contact_cache,
+        size_t ticks) {
+    auto env = make_environment(static_collision, contact_cache);
+    Random_player players[] = {Random_player(0, 1), Random_player(1, 2)};
+    size_t sender = 0;
+    size_t substeps = 0;
+    auto start = Clock::now();
+    for (size_t t = 0; t < ticks; ++t) {
+        auto state = env.get_state();
+        auto a1 = players[0].get_action(state);
+        auto a2 = players[1].get_action(state);
+        int winner = env.step(a1, a2);
+        substeps += env.get_last_substeps();
+        if (winner != -1) {
+            sender = 1 - sender;
+            env.reset(sender);
+        }
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return elapsed.count()/substeps*1e9;
+}
+
+// Plays the same match with boxes and packed and compares the states bit
+// by bit after every tick.
+size_t compare_match(size_t ticks) {
+    auto boxes = make_environment(Static_collision::boxes, false);
+    auto packed = make_environment(Static_collision::packed, false);
+    Random_player players[] = {Random_player(0, 1), Random_player(1, 2)};
+    size_t sender = 0;
+    size_t mismatches = 0;
+    for (size_t t = 0; t < ticks; ++t) {
+        auto state = boxes.get_state();
+        auto a1 = players[0].get_action(state);
+        auto a2 = players[1].get_action(state);
+        int boxes_winner = boxes.step(a1, a2);
+        int packed_winner = packed.step(a1, a2);
+        if (boxes_winner != packed_winner ||
+                !same_bits(boxes.get_state(), packed.get_state())) {
+            ++mismatches;
+            packed.set_state(boxes.get_state());
+        }
+        if (boxes_winner != -1) {
+            sender = 1 - sender;
+            boxes.reset(sender);
+            packed.reset(sender);
+        }
+    }
+    return mismatches;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t ticks = argc > 1? std::stoul(argv[1]) : 200000;
+    size_t mismatches = run_kernels(4096);
+
+    size_t match_mismatches = compare_match(ticks);
+    std::cout << ticks << " ticks of a random match, fast path off"
+              << std::endl
+              << std::fixed << std::setprecision(1)
+              << "  ns per substep: boxes "
+              << measure_match(Static_collision::boxes, false, ticks)
+              << ", boxes with the contact cache "
+              << measure_match(Static_collision::boxes, true, ticks)
+              << ", packed "
+              << measure_match(Static_collision::packed, false, ticks)
+              << std::endl << std::defaultfloat
+              << "  ticks that differ from boxes: " << match_mismatches
+              << std::endl;
+    return mismatches + match_mismatches == 0? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include "packed_boxes.hpp"
+
+#include <cassert>
+
+
+ash::Packed_boxes::Packed_boxes(const std::vector<AABB>& boxes) :
+    count(boxes.size()),
+    padded_count((boxes.size() + Pack::lanes - 1)/Pack::lanes*Pack::lanes)
+{
+    assert(padded_count <= capacity);
+    // far enough from any table for the broadphase to reject them, close
+    // enough for every difference to stay finite
+    AABB out_of_reach = {1e30, 1e30 + 1e15, 1e30, 1e30 + 1e15};
+    for (size_t i = 0; i < capacity; ++i) {
+        const auto& box = i < count? boxes[i] : out_of_reach;
+        x_min[i] = box.x_min;
+        x_max[i] = box.x_max;
+        y_min[i] = box.y_min;
+        y_max[i] = box.y_max;
+    }
+}
+
+void ash::Packed_boxes::collide(const Vector_2d& position, double radius,
+        Contacts& out) const {
+    typedef Vector_2d_pack<Pack::lanes> Vector_pack;
+    // The operations of broadphase_test and of collides(Box&, Disk&), in
+    // the same order; see there for the regions of the box.
+    auto disk_box = AABB{position.x - radius, position.x + radius,
+        position.y - radius, position.y + radius};
+    auto disk_x_min = Pack::broadcast(disk_box.x_min);
+    auto disk_x_max = Pack::broadcast(disk_box.x_max);
+    auto disk_y_min = Pack::broadcast(disk_box.y_min);
+    auto disk_y_max = Pack::broadcast(disk_box.y_max);
+    auto p = Vector_pack::broadcast(position);
+    auto r = Pack::broadcast(radius);
+    auto r_sq = Pack::broadcast(radius*radius);
+    auto zero = Pack::broadcast(0);
+    auto one = Pack::broadcast(1);
+    auto minus_one = Pack::broadcast(-1);
+
+    out.mask = 0;
+    for (size_t k = 0; k < padded_count; k += Pack::lanes) {
+        auto x_min = Pack::load(&this->x_min[k]);
+        auto x_max = Pack::load(&this->x_max[k]);
+        auto y_min = Pack::load(&this->y_min[k]);
+        auto y_max = Pack::load(&this->y_max[k]);
+
+        auto broad = (x_max > disk_x_min) & (disk_x_max > x_min) &
+            (y_max > disk_y_min) & (disk_y_max > y_min);
+        // most of the time the disk is far from every box of the pack
+        if (broad.get_bits() == 0) {
+            continue;
+        }
+
+        Vector_pack v1 = {x_max - x_min, y_max - y_min};
+        Vector_pack v2 = {x_max - x_min, y_min - y_max};
+        Vector_pack u1 = {p.x - x_min, p.y - y_min};
+        Vector_pack u2 = {p.x - x_min, p.y - y_max};
+        auto ab = v1.x*u1.y - v1.y*u1.x > zero;
+        auto bc = v2.x*u2.y - v2.y*u2.x > zero;
+
+        // bottom and top borders, the others being left and right
+        auto horizontal = (ab & bc) | !(ab | bc);
+        auto clamped_x = select(p.x < x_min, x_min,
+                select(p.x > x_max, x_max, p.x));
+        auto clamped_y = select(p.y < y_min, y_min,
+                select(p.y > y_max, y_max, p.y));
+        Vector_pack closest = {
+            select(horizontal, clamped_x, select(bc, x_max, x_min)),
+            select(horizontal, select(ab, y_max, y_min), clamped_y)};
+        Vector_pack normal = {
+            select(horizontal, zero, select(bc, one, minus_one)),
+            select(horizontal, select(ab, one, minus_one), zero)};
+
+        auto closest_to_p = p - closest;
+        auto distance_sq = closest_to_p.norm_sq();
+        auto inside = (x_min < p.x) & (p.x < x_max) & (y_min < p.y) &
+            (p.y < y_max);
+        auto hit = (broad & (inside | (distance_sq < r_sq))).get_bits();
+        if (hit == 0) {
+            continue;
+        }
+        out.mask |= hit << k;
+
+        // lanes at distance zero divide by zero, but are not selected
+        auto distance = sqrt(distance_sq);
+        normal = select(distance == zero, normal, closest_to_p/distance);
+        auto penetration = select(inside, r + distance, r - distance);
+        penetration.store(&out.penetration[k]);
+        normal.store(&out.normal_x[k], &out.normal_y[k]);
+    }
+}
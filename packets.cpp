@@ -0,0 +1,54 @@
+#include "packets.hpp"
+
+
+sf::Packet& ash::operator<<(sf::Packet& packet, const Vector_2d& v) {
+    return packet << v.x << v.y;
+}
+
+sf::Packet& ash::operator>>(sf::Packet& packet, Vector_2d& v) {
+    return packet >> v.x >> v.y;
+}
+
+sf::Packet& ash::operator<<(sf::Packet& packet,
+        const Environment::State::BodyStatus& status) {
+    return packet << status.position << status.velocity;
+}
+
+sf::Packet& ash::operator>>(sf::Packet& packet,
+        Environment::State::BodyStatus& status) {
+    return packet >> status.position >> status.velocity;
+}
+
+sf::Packet& ash::operator<<(sf::Packet& packet,
+        const Environment::State& state) {
+    return packet << state.mallets[0] << state.mallets[1] << state.puck;
+}
+
+sf::Packet& ash::operator>>(sf::Packet& packet, Environment::State& state) {
+    return packet >> state.mallets[0] >> state.mallets[1] >> state.puck;
+}
+
+sf::Packet& ash::operator<<(sf::Packet& packet, const Game_state& state) {
+    packet << state.environment.get_state()
+           << state.accumulator
+           << sf::Int32(state.score[0]) << sf::Int32(state.score[1])
+           << sf::Int32(state.sender)
+           << sf::Int32(state.new_game);
+    return packet;
+}
+
+sf::Packet& ash::operator>>(sf::Packet& packet, Game_state& state) {
+    Environment::State env_state;
+    sf::Int32 score_0, score_1, sender, new_game;
+    packet >> env_state
+           >> state.accumulator
+           >> score_0 >> score_1
+           >> sender
+           >> new_game;
+    state.environment.set_state(env_state);
+    state.score[0] = score_0;
+    state.score[1] = score_1;
+    state.sender = sender;
+    state.new_game = new_game;
+    return packet;
+}
@@ -0,0 +1,81 @@
+#include "benchmark_support.hpp"
+#include "physics.hpp"
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+
+namespace {
+
+typedef ash::benchmark::Action_pair Action_pair;
+typedef ash::Environment::Collision_detection Collision_detection;
+using ash::benchmark::same_bits;
+
+template<class Environment>
+void play(Environment& env, const std::vector<Action_pair>& schedule,
+        size_t t, size_t& sender) {
+    if (env.step(schedule[t][0], schedule[t][1]) != -1) {
+        sender = 1 - sender;
+        env.reset(sender);
+    }
+}
+
+// Plays the same schedule with the specialized and the runtime environment
+// and compares the states bit by bit after every tick. Prints a line of the
+// report and returns the number of mismatching ticks.
+template<const ash::Parameter_set& set>
+size_t compare(const char* name, Collision_detection collision_detection,
+        const std::vector<Action_pair>& schedule) {
+    ash::Constant_environment<set> constant;
+    ash::Runtime_environment runtime(set);
+    constant.set_collision_detection(collision_detection);
+    runtime.set_collision_detection(collision_detection);
+    size_t mismatches = 0;
+    size_t constant_sender = 0, runtime_sender = 0;
+    for (size_t t = 0; t < schedule.size(); ++t) {
+        play(constant, schedule, t, constant_sender);
+        play(runtime, schedule, t, runtime_sender);
+        if (!same_bits(constant.get_state(), runtime.get_state())) {
+            ++mismatches;
+            runtime.set_state(constant.get_state());
+        }
+    }
+    double constant_rate = ash::benchmark::steps_per_second(constant,
+            schedule);
+    double runtime_rate = ash::benchmark::steps_per_second(runtime,
+            schedule);
+    std::cout << std::fixed
+              << std::setw(12) << name
+              << std::setw(12) << mismatches
+              << std::setw(16) << std::setprecision(0) << constant_rate
+              << std::setw(15) << runtime_rate
+              << std::setw(10) << std::setprecision(2)
+              << constant_rate/runtime_rate << std::endl;
+    return mismatches;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t ticks = argc > 1? std::stoul(argv[1]) : 200000;
+    auto schedule = ash::benchmark::make_schedule(ticks);
+
+    // the specialized default table is the one Environment has always
+    // been, so its rate is that of the constexpr build
+    std::cout << ticks << " ticks" << std::endl;
+    std::cout << std::setw(12) << "parameters"
+              << std::setw(12) << "mismatches"
+              << std::setw(16) << "constant step/s"
+              << std::setw(15) << "runtime step/s"
+              << std::setw(10) << "speedup" << std::endl;
+    size_t total_mismatches = 0;
+    total_mismatches += compare<ash::default_parameters>("default",
+            Collision_detection::discrete, schedule);
+    total_mismatches += compare<ash::high_rate_parameters>("high rate",
+            Collision_detection::discrete, schedule);
+    total_mismatches += compare<ash::rollout_parameters>("rollout",
+            Collision_detection::swept, schedule);
+    return total_mismatches == 0? 0 : 1;
+}
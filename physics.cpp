@@ -1,6 +1,10 @@
 #include "physics.hpp"
 
 #include <cassert>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <mutex>
 
 
 namespace {
@@ -11,33 +15,330 @@ inline constexpr auto merge(ash::Body_type l, ash::Body_type r) {
         static_cast<Body_index>(r);
 }
 
-std::optional<ash::Collision> collides_box_vs_box (
-        ash::Body& base_a, ash::Body& base_b) {
-    auto* a = static_cast<ash::Box*>(&base_a);
-    auto* b = static_cast<ash::Box*>(&base_b);
-    const auto& bb_a = a->get_bounding_box();
-    const auto& bb_b = b->get_bounding_box();
+template<class Scalar>
+ash::Basic_aabb<Scalar> grow(const ash::Basic_aabb<Scalar>& box,
+        typename ash::Basic_aabb<Scalar>::Scalar amount) {
+    ash::Basic_aabb<Scalar> out;
+    out.x_min = box.x_min - amount;
+    out.x_max = box.x_max + amount;
+    out.y_min = box.y_min - amount;
+    out.y_max = box.y_max + amount;
+    return out;
+}
+
+std::uint64_t get_bits(double x) {
+    std::uint64_t out;
+    std::memcpy(&out, &x, sizeof(x));
+    return out;
+}
+
+std::uint64_t get_bits(float x) {
+    std::uint32_t out;
+    std::memcpy(&out, &x, sizeof(x));
+    return out;
+}
+
+std::uint64_t get_bits(ash::Fixed x) {
+    return static_cast<std::uint64_t>(x.get_raw());
+}
+
+// the derivatives are not part of the state
+std::uint64_t get_bits(const ash::Dual_scalar& x) {
+    return get_bits(x.get_value());
+}
+
+// The conservative bounds leave room for rounding (see bound_margin), and
+// nothing in the state depends on them, so in fixed point, where every
+// product takes a handful of integer instructions, they are worked out in
+// floating point.
+template<class Scalar>
+struct Bound_scalar_of {
+    typedef Scalar type;
+};
+
+template<>
+struct Bound_scalar_of<ash::Fixed> {
+    typedef double type;
+};
+
+template<class Scalar>
+using Bound_scalar = typename Bound_scalar_of<Scalar>::type;
+
+// -1, 0 or 1
+template<class Scalar>
+Scalar sign(Scalar x) {
+    return x > 0? Scalar(1) : x < 0? Scalar(-1) : Scalar(0);
+}
+
+// v + f*inv_mass*h. In fixed point a zero force, which changes nothing,
+// is skipped; in floating point it still turns a -0 into a 0.
+template<class Scalar>
+ash::Basic_vector_2d<Scalar> accelerate(const ash::Basic_vector_2d<Scalar>& v,
+        const ash::Basic_vector_2d<Scalar>& f, Scalar inv_mass, Scalar h) {
+    if constexpr (std::numeric_limits<Scalar>::is_exact) {
+        if (f.is_zero()) {
+            return v;
+        }
+    }
+    return v + f*inv_mass*h;
+}
+
+// length of v, for the bounds
+template<class Scalar>
+Bound_scalar<Scalar> bound_norm(const ash::Basic_vector_2d<Scalar>& v) {
+    using std::sqrt;
+    return sqrt(static_cast<Bound_scalar<Scalar>>(v.norm_sq()));
+}
+
+// The gains of the controller, in Scalar. Callers convert them once, out
+// of their loops; with the parameters known at compile time, the compiler
+// does it (a conversion to fixed point is not free).
+template<class Scalar>
+struct Pd_gains {
+    Scalar kp;
+    Scalar kd;
+    Scalar max_p_force;
+    Scalar max_p_force_sq;
+    // the same limit, on the distance to the target
+    Scalar max_error_sq;
+};
+
+template<class Scalar>
+constexpr Pd_gains<Scalar> get_pd_gains(const ash::Parameter_set& config) {
+    Scalar max_p_force(config.kd*config.mallet_max_velocity);
+    double max_error = config.kd*config.mallet_max_velocity/config.kp;
+    return {Scalar(config.kp), Scalar(config.kd), max_p_force,
+        max_p_force*max_p_force, Scalar(max_error*max_error)};
+}
+
+template<class Scalar>
+ash::Basic_vector_2d<Scalar> pd_control(const Pd_gains<Scalar>& gains,
+        const ash::Basic_vector_2d<Scalar>& t,
+        const ash::Basic_vector_2d<Scalar>& position,
+        const ash::Basic_vector_2d<Scalar>& velocity) {
+    const Scalar& max_p_force = gains.max_p_force;
+    auto p = gains.kp*(t-position);
+    auto p_mag_sq = p.norm_sq();
+    if (p_mag_sq > gains.max_p_force_sq) {
+        using std::sqrt;
+        p = max_p_force/sqrt(p_mag_sq) * p;
+    }
+    auto d = - gains.kd*velocity;
+    return p + d;
+}
+
+template<class Scalar>
+ash::Basic_vector_2d<Scalar> pd_control(const Pd_gains<Scalar>& gains,
+        const ash::Basic_vector_2d<Scalar>& t,
+        const ash::Basic_body<Scalar>& b) {
+    return pd_control(gains, t, b.get_position(), b.get_velocity());
+}
+
+// A substep of semi-implicit Euler for a mallet under the controller:
+// v' = v + (f + p + d)*h/m, with f the force applied before the step, then
+// x' = x + v'*h. In fixed point, where a product takes a handful of integer
+// instructions, the gains are folded with h/m once per step, which saves a
+// third of the products of a substep. The rounding is not the same, so
+// every Euler substep of a mallet goes through here.
+template<class Scalar>
+class Mallet_stepper {
+    public:
+        typedef ash::Basic_vector_2d<Scalar> Vector_2d;
+
+        Mallet_stepper(const Pd_gains<Scalar>& gains, Scalar inv_mass,
+                Scalar h) :
+            gains(gains), inv_mass(inv_mass), h(h), kp_h_m(), damping(),
+            max_p_force_h_m() {
+            if constexpr (std::numeric_limits<Scalar>::is_exact) {
+                Scalar h_m = inv_mass*h;
+                kp_h_m = gains.kp*h_m;
+                damping = 1 - gains.kd*h_m;
+                max_p_force_h_m = gains.max_p_force*h_m;
+            }
+        }
+
+        Vector_2d velocity(const Vector_2d& target,
+                const Vector_2d& position, const Vector_2d& velocity,
+                const Vector_2d& pending) const {
+            if constexpr (std::numeric_limits<Scalar>::is_exact) {
+                auto error = target - position;
+                auto error_sq = error.norm_sq();
+                auto next = damping*velocity;
+                if (error_sq > gains.max_error_sq) {
+                    using std::sqrt;
+                    next += max_p_force_h_m/sqrt(error_sq)*error;
+                }
+                else {
+                    next += kp_h_m*error;
+                }
+                return accelerate(next, pending, inv_mass, h);
+            }
+            else {
+                return velocity + (pending +
+                        pd_control(gains, target, position, velocity))*
+                    inv_mass*h;
+            }
+        }
+
+        Vector_2d position(const Vector_2d& position,
+                const Vector_2d& velocity) const {
+            return position + velocity*h;
+        }
+
+    private:
+        Pd_gains<Scalar> gains;
+        Scalar inv_mass;
+        Scalar h;
+        // fixed point only
+        Scalar kp_h_m;
+        Scalar damping;
+        Scalar max_p_force_h_m;
+};
+
+template<class Scalar>
+constexpr ash::Basic_rink<Scalar> make_rink(const ash::Parameter_set& config) {
+    typedef ash::Basic_vector_2d<Scalar> Vector_2d;
+    typedef ash::Basic_box<Scalar> Box;
+    ash::Basic_rink<Scalar> rink{};
+
+    // construct walls
+    for (size_t i = 0; i < 6; ++i) {
+        Scalar w = 0, h = 0, x = 0, y = 0;
+        if (i < 2) {
+            Scalar d = config.field_width +
+                config.wall_thickness;
+            w = config.field_length + 2*config.wall_thickness;
+            h = config.wall_thickness;
+            x = 0;
+            y = d/2 - i*d;
+        }
+        else {
+            Scalar d = config.field_length +
+                config.wall_thickness;
+            Scalar e = (config.field_width + config.goal_width)/2;
+            w = config.wall_thickness;
+            h = (config.field_width - config.goal_width)/2;
+            x = -d/2 + (i%2)*d;
+            y = e/2 - (i>3)*e;
+        }
+        rink.walls[i] = Box(Vector_2d(w,h), ash::inf);
+        rink.walls[i].set_position(Vector_2d(x,y));
+    }
+
+    // construct barriers
+    for (size_t i = 0; i < 2; ++i) {
+        Scalar w = config.wall_thickness;
+        Scalar h = config.goal_width;
+        Scalar x = (config.field_length + config.wall_thickness)*(2*i - 1.0)/2;
+        rink.barriers[i] = Box(Vector_2d(w,h), ash::inf);
+        rink.barriers[i].set_position(Vector_2d(x,0));
+    }
+    rink.barriers[2] = Box(
+            Vector_2d(config.wall_thickness,config.field_width), ash::inf);
+    return rink;
+}
+
+// the rinks of the configurations compiled in are laid out by the compiler
+template<class Scalar, class Parameters>
+constexpr ash::Basic_rink<Scalar> constant_rink =
+    make_rink<Scalar>(Parameters::get());
+
+// One value per key, built the first time it is asked for and shared from
+// then on. Map nodes do not move, so references to the values can be handed
+// out while other keys are added.
+template<class Value, class Key, class Build>
+const Value& get_shared(const Key& key, Build build) {
+    static std::mutex mutex;
+    static std::map<Key, Value> values;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = values.find(key);
+    if (found != values.end()) {
+        return found->second;
+    }
+    return values.emplace(key, build()).first->second;
+}
+
+// bodies as numbered by the contact cache
+constexpr size_t wall_slot = 0;
+constexpr size_t barrier_slot = 6;
+constexpr size_t mallet_slot = 9;
+constexpr size_t puck_slot = 11;
+constexpr size_t slot_count = 12;
+
+struct Cached_pair {
+    size_t a;
+    size_t b;
+};
+
+// the bodies of each pair, in the order of Contact_stats
+constexpr std::array<Cached_pair,26> cached_pairs = [] {
+    std::array<Cached_pair,26> out{};
+    for (size_t i = 0; i < 6; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            out[i*2 + j] = {wall_slot + i, mallet_slot + j};
+        }
+    }
+    for (size_t i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            out[12 + i*2 + j] = {barrier_slot + i, mallet_slot + j};
+        }
+    }
+    for (size_t i = 0; i < 6; ++i) {
+        out[18 + i] = {wall_slot + i, puck_slot};
+    }
+    for (size_t j = 0; j < 2; ++j) {
+        out[24 + j] = {mallet_slot + j, puck_slot};
+    }
+    return out;
+}();
+
+}
+
+template<class Scalar, class Parameters>
+struct ash::Basic_environment<Scalar, Parameters>::Contact_cache {
+    // whether the gaps and travels below hold for the rest of the tick
+    bool valid;
+    // lower bound on the distance between the bounding boxes of each pair
+    // at the beginning of the tick
+    std::array<Bound_scalar<Scalar>,pair_count> gaps;
+    // bound on the distance covered by each body during the tick
+    std::array<Bound_scalar<Scalar>,slot_count> travel;
+};
+
+template<class Scalar, class Parameters>
+struct ash::Basic_environment<Scalar, Parameters>::Mallet_steppers {
+    std::array<Mallet_stepper<Scalar>,2> mallets;
+};
+
+
+template<class Scalar>
+std::optional<ash::Basic_collision<Scalar>> ash::collides(
+        Basic_box<Scalar>& a, Basic_box<Scalar>& b) {
+    typedef Basic_vector_2d<Scalar> Vector_2d;
+    typedef Basic_collision<Scalar> Collision;
+    const auto& bb_a = a.get_bounding_box();
+    const auto& bb_b = b.get_bounding_box();
 
     if (bb_a.intersects(bb_b)) {
-        double pen_right = bb_a.x_max - bb_b.x_min;
-        double pen_left = bb_b.x_max - bb_a.x_min;
-        double pen_up = bb_a.y_max - bb_b.y_min;
-        double pen_down = bb_b.y_max - bb_a.y_min;
-        ash::Collision out;
-        out.a = a;
-        out.b = b;
-        out.normal = ash::Vector_2d(1,0);
+        Scalar pen_right = bb_a.x_max - bb_b.x_min;
+        Scalar pen_left = bb_b.x_max - bb_a.x_min;
+        Scalar pen_up = bb_a.y_max - bb_b.y_min;
+        Scalar pen_down = bb_b.y_max - bb_a.y_min;
+        Collision out;
+        out.a = &a;
+        out.b = &b;
+        out.normal = Vector_2d(1,0);
         out.penetration = pen_right; 
         if (pen_left < out.penetration) {
-            out.normal = ash::Vector_2d(-1, 0);
+            out.normal = Vector_2d(-1, 0);
             out.penetration = pen_left;
         }
         if (pen_up < out.penetration) {
-            out.normal = ash::Vector_2d(0, 1);
+            out.normal = Vector_2d(0, 1);
             out.penetration = pen_up;
         }
         if (pen_down < out.penetration) {
-            out.normal = ash::Vector_2d(0, -1);
+            out.normal = Vector_2d(0, -1);
             out.penetration = pen_down;
         }
         return out;
@@ -45,8 +346,11 @@ std::optional<ash::Collision> collides_box_vs_box (
     return {};
 }
 
-std::optional<ash::Collision> collides_box_vs_disk(
-        ash::Body& base_a, ash::Body& base_b) {
+template<class Scalar>
+std::optional<ash::Basic_collision<Scalar>> ash::collides(
+        Basic_box<Scalar>& a, Basic_disk<Scalar>& b) {
+    typedef Basic_vector_2d<Scalar> Vector_2d;
+    typedef Basic_collision<Scalar> Collision;
     // (xmin,ymax)       (xmax,ymax)
     //            +-----+
     //            |\ B /|  . P(x,y) 
@@ -63,56 +367,69 @@ std::optional<ash::Collision> collides_box_vs_disk(
     // u1 = (x-xmin,y-ymin)
     // u2 = (x-xmin,y-ymax)
     
-    auto* a = static_cast<ash::Box*>(&base_a);
-    auto* b = static_cast<ash::Disk*>(&base_b);
-    const auto& bb_a = a->get_bounding_box();
-    const auto& pos_b = b->get_position();
-    double radius = b->get_radius();
+    const auto& bb_a = a.get_bounding_box();
+    const auto& pos_b = b.get_position();
+    Scalar radius = b.get_radius();
 
-    ash::Vector_2d v1(bb_a.x_max-bb_a.x_min, bb_a.y_max-bb_a.y_min);
-    ash::Vector_2d v2(bb_a.x_max-bb_a.x_min, bb_a.y_min-bb_a.y_max);
-    ash::Vector_2d u1(pos_b.x-bb_a.x_min, pos_b.y-bb_a.y_min);
-    ash::Vector_2d u2(pos_b.x-bb_a.x_min, pos_b.y-bb_a.y_max);
+    Vector_2d v1(bb_a.x_max-bb_a.x_min, bb_a.y_max-bb_a.y_min);
+    Vector_2d v2(bb_a.x_max-bb_a.x_min, bb_a.y_min-bb_a.y_max);
+    Vector_2d u1(pos_b.x-bb_a.x_min, pos_b.y-bb_a.y_min);
+    Vector_2d u2(pos_b.x-bb_a.x_min, pos_b.y-bb_a.y_max);
 
     bool ab = v1.x*u1.y - v1.y*u1.x > 0;
     bool bc = v2.x*u2.y - v2.y*u2.x > 0;
 
-    ash::Vector_2d closest;
-    ash::Vector_2d normal;
+    Vector_2d closest;
+    Vector_2d normal;
 
     if (!ab && !bc) {
         // bottom border
-        closest = ash::Vector_2d(
-                ash::clamp(pos_b.x, bb_a.x_min, bb_a.x_max), bb_a.y_min);
-        normal = ash::Vector_2d(0, -1);
+        closest = Vector_2d(
+                clamp(pos_b.x, bb_a.x_min, bb_a.x_max), bb_a.y_min);
+        normal = Vector_2d(0, -1);
     }
     else if (!ab && bc) {
         // right border
-        closest = ash::Vector_2d(
-                bb_a.x_max, ash::clamp(pos_b.y, bb_a.y_min, bb_a.y_max));
-        normal = ash::Vector_2d(1, 0);
+        closest = Vector_2d(
+                bb_a.x_max, clamp(pos_b.y, bb_a.y_min, bb_a.y_max));
+        normal = Vector_2d(1, 0);
     }
     else if (ab && !bc) {
         // left border
-        closest = ash::Vector_2d(
-                bb_a.x_min, ash::clamp(pos_b.y, bb_a.y_min, bb_a.y_max));
-        normal = ash::Vector_2d(-1, 0);
+        closest = Vector_2d(
+                bb_a.x_min, clamp(pos_b.y, bb_a.y_min, bb_a.y_max));
+        normal = Vector_2d(-1, 0);
     }
     else { 
         // top border
-        closest = ash::Vector_2d(
-                ash::clamp(pos_b.x, bb_a.x_min, bb_a.x_max), bb_a.y_max);
-        normal = ash::Vector_2d(0, 1);
+        closest = Vector_2d(
+                clamp(pos_b.x, bb_a.x_min, bb_a.x_max), bb_a.y_max);
+        normal = Vector_2d(0, 1);
     }
     auto closest_to_b = pos_b - closest;
-    double distance = closest_to_b.norm_sq();
+    Scalar distance = closest_to_b.norm_sq();
     bool inside = bb_a.contains(pos_b);
     if (inside || distance < radius*radius) {
-        distance = sqrt(distance);
-        ash::Collision out;
-        out.a = a;
-        out.b = b;
-        out.normal = distance==0? normal : (closest_to_b/distance);
+        Collision out;
+        out.a = &a;
+        out.b = &b;
+        if (closest_to_b.x == 0 || closest_to_b.y == 0) {
+            // Off a side, the distance and the normal need neither a square
+            // root nor a division: in floating point they come out the same
+            // as below, in fixed point they come out exact.
+            using std::abs;
+            distance = abs(closest_to_b.x + closest_to_b.y);
+            if (distance != 0) {
+                normal = Vector_2d(sign(closest_to_b.x),
+                        sign(closest_to_b.y));
+            }
+            out.normal = normal;
+        }
+        else {
+            using std::sqrt;
+            distance = sqrt(distance);
+            out.normal = distance==0? normal : closest_to_b/distance;
+        }
         out.penetration = inside? (radius + distance) :
             (radius - distance);
         return out;
@@ -121,103 +438,110 @@ std::optional<ash::Collision> collides_box_vs_disk(
     return {};
 }
 
-std::optional<ash::Collision> collides_disk_vs_disk(
-        ash::Body& base_a, ash::Body& base_b) {
-    auto* a = static_cast<ash::Disk*>(&base_a);
-    auto* b = static_cast<ash::Disk*>(&base_b);
-    double sum_radius = a->get_radius() + b->get_radius();
-    auto displacement = b->get_position() - a->get_position();
-    double distance_sq = displacement.norm_sq();
+template<class Scalar>
+std::optional<ash::Basic_collision<Scalar>> ash::collides(
+        Basic_disk<Scalar>& a, Basic_box<Scalar>& b) {
+    return collides(b, a);
+}
+
+template<class Scalar>
+std::optional<ash::Basic_collision<Scalar>> ash::collides(
+        Basic_disk<Scalar>& a, Basic_disk<Scalar>& b) {
+    typedef Basic_vector_2d<Scalar> Vector_2d;
+    typedef Basic_collision<Scalar> Collision;
+    Scalar sum_radius = a.get_radius() + b.get_radius();
+    auto displacement = b.get_position() - a.get_position();
+    Scalar distance_sq = displacement.norm_sq();
     if (distance_sq < sum_radius*sum_radius) {
-        double distance = sqrt(distance_sq);
-        ash::Collision out;
-        out.a = a;
-        out.b = b;
+        using std::sqrt;
+        Scalar distance = sqrt(distance_sq);
+        Collision out;
+        out.a = &a;
+        out.b = &b;
         out.penetration = sum_radius - distance;
         out.normal = distance_sq == 0?
-            ash::Vector_2d(1,0) :
+            Vector_2d(1,0) :
             displacement/distance;
         return out;
     }
     return {};
 }
 
-ash::Vector_2d pd_control(const ash::Vector_2d& t, const ash::Body& b) {
-    using namespace ::ash::parameters;
-    constexpr double max_p_force = kd*mallet_max_velocity;
-    auto p = kp*(t-b.get_position());
-    auto p_mag_sq = p.norm_sq();
-    if (p_mag_sq > max_p_force*max_p_force) {
-        p = max_p_force/sqrt(p_mag_sq) * p;
+template<class Scalar>
+ash::Basic_aabb<Scalar> ash::Basic_body<Scalar>::get_bounding_box() const {
+    typedef Basic_box<Scalar> Box;
+    typedef Basic_disk<Scalar> Disk;
+    switch (type) {
+        case Body_type::Box:
+            return static_cast<const Box*>(this)->get_bounding_box();
+        case Body_type::Disk:
+            return static_cast<const Disk*>(this)->get_bounding_box();
+        default:
+            assert(false);
     }
-    auto d = - kd*b.get_velocity();
-    return p + d;
-}
-
-}
-
-
-ash::AABB ash::Disk::get_bounding_box() const {
-    const auto& position = get_position();
-    AABB result;
-    result.x_min = position.x - radius;
-    result.x_max = position.x + radius;
-    result.y_min = position.y - radius;
-    result.y_max = position.y + radius;
-    return result;
-}
-
-ash::AABB ash::Box::get_bounding_box() const {
-    const auto& position = get_position();
-    AABB result;
-    result.x_min = position.x - size.x/2;
-    result.x_max = position.x + size.x/2;
-    result.y_min = position.y - size.y/2;
-    result.y_max = position.y + size.y/2;
-    return result;
-}
-
-bool ash::broadphase_test(const Body& a, const Body& b) {
-    auto bb_a = a.get_bounding_box();
-    auto bb_b = b.get_bounding_box();
-    return bb_a.intersects(bb_b);
+    return {};
 }
 
-std::optional<ash::Collision> ash::collides(Body& a, Body& b) {
+template<class Scalar>
+std::optional<ash::Basic_collision<Scalar>> ash::collides(
+        Basic_body<Scalar>& a, Basic_body<Scalar>& b) {
+    typedef Basic_box<Scalar> Box;
+    typedef Basic_disk<Scalar> Disk;
     switch (merge(a.get_type(),b.get_type())) {
         case merge(Body_type::Box,  Body_type::Box):
-            return collides_box_vs_box(a, b);
+            return collides(static_cast<Box&>(a), static_cast<Box&>(b));
         case merge(Body_type::Box,  Body_type::Disk):
-            return collides_box_vs_disk(a, b);
+            return collides(static_cast<Box&>(a), static_cast<Disk&>(b));
         case merge(Body_type::Disk, Body_type::Box):
-            return collides_box_vs_disk(b, a);
+            return collides(static_cast<Disk&>(a), static_cast<Box&>(b));
         case merge(Body_type::Disk, Body_type::Disk):
-            return collides_disk_vs_disk(a, b);
+            return collides(static_cast<Disk&>(a), static_cast<Disk&>(b));
         default:
             assert(false);
     }
     return {};
 }
 
-void ash::resolve_collision(Collision& collision, double restitution) {
+template<class Scalar>
+ash::Basic_response_weights<Scalar> ash::response_weights(Scalar inv_mass_a,
+        Scalar inv_mass_b) {
+    Scalar den = inv_mass_a + inv_mass_b;
+    return {inv_mass_a / den, inv_mass_b / den};
+}
+
+template<class Scalar>
+void ash::resolve_collision(Basic_collision<Scalar>& collision,
+        Scalar restitution) {
+    resolve_collision(collision, restitution, response_weights(
+                collision.a->get_inv_mass(), collision.b->get_inv_mass()));
+}
+
+template<class Scalar>
+void ash::resolve_collision(Basic_collision<Scalar>& collision,
+        Scalar restitution, const Basic_response_weights<Scalar>& weights) {
     auto& a = *collision.a;
     auto& b = *collision.b;
     auto v_a = a.get_velocity();
     auto v_b = b.get_velocity();
     auto v_ab_n = collision.normal.dot(v_b - v_a);
     if (v_ab_n < 0) {
-        double den = a.get_inv_mass()+b.get_inv_mass();
-        double w1 = a.get_inv_mass() / den;
-        double w2 = b.get_inv_mass() / den;
-        v_a += (w1*(1+restitution)*v_ab_n) * collision.normal;
-        v_b -= (w2*(1+restitution)*v_ab_n) * collision.normal;
+        v_a += (weights.a*(1+restitution)*v_ab_n) * collision.normal;
+        v_b -= (weights.b*(1+restitution)*v_ab_n) * collision.normal;
         a.set_velocity(v_a);
         b.set_velocity(v_b);
     }
 }
 
-void ash::correct_position(
-        Collision& collision, double slop, double amount) {
+template<class Scalar>
+void ash::correct_position(Basic_collision<Scalar>& collision, Scalar slop,
+        Scalar amount) {
+    correct_position(collision, slop, amount, response_weights(
+                collision.a->get_inv_mass(), collision.b->get_inv_mass()));
+}
+
+template<class Scalar>
+void ash::correct_position(Basic_collision<Scalar>& collision, Scalar slop,
+        Scalar amount, const Basic_response_weights<Scalar>& weights) {
     if (collision.penetration < slop) {
         return;
     }
@@ -225,93 +549,349 @@ void ash::correct_position(
     auto& b = *collision.b;
     auto pos_a = a.get_position();
     auto pos_b = b.get_position();
-    double den = a.get_inv_mass() + b.get_inv_mass();
-    double w1 = a.get_inv_mass() / den;
-    double w2 = b.get_inv_mass() / den;
-    pos_a -= w1*amount*collision.penetration * collision.normal;
-    pos_b += w2*amount*collision.penetration * collision.normal;
+    pos_a -= weights.a*amount*collision.penetration * collision.normal;
+    pos_b += weights.b*amount*collision.penetration * collision.normal;
     a.set_position(pos_a);
     b.set_position(pos_b);
 }
 
-ash::Environment::Environment() {
-    using namespace ::ash::parameters;
+template<class Scalar, class Parameters>
+ash::Basic_environment<Scalar, Parameters>::Basic_environment(
+        const Parameters& parameters) :
+    parameters(parameters)
+{
+    const auto& config = get_parameters();
 
-    // construct walls
-    for (size_t i = 0; i < 6; ++i) {
-        double w, h, x, y;
-        if (i < 2) {
-            double d = field_width +
-                wall_thickness;
-            w = field_length + 2*wall_thickness;
-            h = wall_thickness;
-            x = 0;
-            y = d/2 - i*d;
-        }
-        else {
-            double d = field_length +
-                wall_thickness;
-            double e = (field_width + goal_width)/2;
-            w = wall_thickness;
-            h = (field_width - goal_width)/2;
-            x = -d/2 + (i%2)*d;
-            y = e/2 - (i>3)*e;
-        }
-        walls[i] = Box(Vector_2d(w,h), inf);
-        walls[i].set_position(Vector_2d(x,y));
+    if constexpr (is_constant_parameters<Parameters>::value) {
+        rink = &constant_rink<Scalar, Parameters>;
     }
-
-    // construct barriers
-    for (size_t i = 0; i < 2; ++i) {
-        double w = wall_thickness;
-        double h = goal_width;
-        double x = (field_length + wall_thickness)*(2*i - 1.0)/2;
-        barriers[i] = Box(Vector_2d(w,h), inf);
-        barriers[i].set_position(Vector_2d(x,0));
+    else {
+        // everything the layout depends on
+        typedef std::array<double,4> Rink_key;
+        Rink_key key = {config.field_length, config.field_width,
+            config.goal_width, config.wall_thickness};
+        rink = &get_shared<Rink>(key, [&config] {
+                return make_rink<Scalar>(config);
+            });
     }
-    barriers[2] = Box(Vector_2d(wall_thickness,field_width), inf);
 
     // construct mallet and puck
     for (size_t i = 0; i < 2; ++i) {
         mallets[i] = Disk(
-                mallet_radius, mallet_mass);
+                config.mallet_radius, config.mallet_mass);
     }
 
-    puck = Disk(puck_radius, puck_mass);
+    puck = Disk(config.puck_radius, config.puck_mass);
 
     // reset mallet and puck position
     reset(0);
 
+    substepping = Substepping::fixed;
+    fixed_substeps = config.substeps;
+    integrator = Integrator::semi_implicit_euler;
+    fast_path = true;
+    static_collision = Static_collision::boxes;
+    static_fields = nullptr;
+    packed_rink = nullptr;
+    contact_cache = true;
+    contact_stats = nullptr;
+    sleeping = false;
+    wake_all();
+    collision_detection = Collision_detection::discrete;
+    last_substeps = 0;
+    last_fast_path = false;
+
 }
 
-void ash::Environment::reset(size_t sender) {
-    using namespace ::ash::parameters;
-    double d = field_length - 2*mallet_radius;
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::reset(size_t sender) {
+    const auto& config = get_parameters();
+    Scalar d = config.field_length - 2*config.mallet_radius;
     // reset mallet positions
     for (size_t i = 0; i < 2; ++i) {
-        double x = -d/2 + i*d;
+        Scalar x = -d/2 + i*d;
         mallets[i].set_position(Vector_2d(x,0));
         mallets[i].set_velocity(Vector_2d(0,0));
     }
     // reset puck position
     {
-        double e = field_length/2;
-        double x = -e/2 + sender*e;
+        Scalar e = config.field_length/2;
+        Scalar x = -e/2 + sender*e;
         puck.set_position(Vector_2d(x, 0));
         puck.set_velocity(Vector_2d(0, 0));
     }
+    wake_all();
 }
 
-int ash::Environment::step(const Action& a1, const Action& a2) {
+template<class Scalar, class Parameters>
+int ash::Basic_environment<Scalar, Parameters>::step(const Action& a1,
+        const Action& a2) {
     // apply forces to mallets
-    using namespace ::ash::parameters;
-    for (int i = 0; i < substeps-1; ++i) {
-        substep(a1, a2);
+    const auto& config = get_parameters();
+    if (sleeping && integrator == Integrator::semi_implicit_euler) {
+        update_sleep(a1, a2);
+        if (mallet_asleep[0] && mallet_asleep[1] && puck_asleep) {
+            last_substeps = 0;
+            last_fast_path = false;
+            return check_goal();
+        }
+    }
+    else {
+        wake_all();
+    }
+    last_substeps = substepping == Substepping::adaptive?
+        adaptive_substeps(a1, a2) : fixed_substeps;
+    Scalar h = config.dt/last_substeps;
+    const auto gains = get_pd_gains<Scalar>(config);
+    const Mallet_steppers steppers = {{
+        Mallet_stepper<Scalar>(gains, mallets[0].get_inv_mass(), h),
+        Mallet_stepper<Scalar>(gains, mallets[1].get_inv_mass(), h)}};
+    // the bounds of contact_free follow semi-implicit Euler only
+    last_fast_path = fast_path &&
+        integrator == Integrator::semi_implicit_euler &&
+        contact_free(a1, a2, last_substeps, h);
+    if (last_fast_path) {
+        integrate_free(a1, a2, last_substeps, h, steppers);
+        return check_goal();
+    }
+    Contact_cache cache;
+    cache.valid = false;
+    if (contact_cache && integrator == Integrator::semi_implicit_euler &&
+            collision_detection == Collision_detection::discrete &&
+            static_collision == Static_collision::boxes) {
+        prepare_contact_cache(cache, last_substeps, h);
+    }
+    for (int i = 0; i < last_substeps-1; ++i) {
+        substep(a1, a2, h, steppers, cache);
+    }
+    return substep(a1, a2, h, steppers, cache);
+}
+
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::update_sleep(const Action& a1,
+        const Action& a2) {
+    const auto& config = get_parameters();
+    const auto gains = get_pd_gains<Scalar>(config);
+    const Action* actions[] = {&a1, &a2};
+    for (size_t i = 0; i < mallets.size(); ++i) {
+        auto force = pd_control(gains, *actions[i], mallets[i]);
+        // a force applied before the step (apply_force) wakes it too
+        if (force.norm_sq() >= config.sleep_force()*config.sleep_force() ||
+                mallets[i].get_velocity().norm_sq() >=
+                config.sleep_velocity*config.sleep_velocity ||
+                !mallets[i].get_force().is_zero()) {
+            mallet_asleep[i] = false;
+            mallet_rest_ticks[i] = 0;
+        }
+        else if (!mallet_asleep[i] &&
+                ++mallet_rest_ticks[i] >= config.sleep_ticks) {
+            mallet_asleep[i] = true;
+            mallets[i].set_velocity(Vector_2d(0, 0));
+        }
     }
-    return substep(a1, a2);
+    if (puck.get_velocity().norm_sq() >=
+            config.sleep_velocity*config.sleep_velocity ||
+            !puck.get_force().is_zero()) {
+        puck_asleep = false;
+        puck_rest_ticks = 0;
+    }
+    else if (!puck_asleep && ++puck_rest_ticks >= config.sleep_ticks) {
+        puck_asleep = true;
+        puck.set_velocity(Vector_2d(0, 0));
+    }
+}
+
+template<class Scalar, class Parameters>
+bool ash::Basic_environment<Scalar, Parameters>::collide_mallet_with_puck(
+        size_t j, Contact_cache& cache) {
+    const auto& config = get_parameters();
+    if (mallet_asleep[j] && puck_asleep) {
+        return false;
+    }
+    if (!handle_collision(mallets[j], puck, config.mallet_puck_restitution,
+                24 + j, cache)) {
+        return false;
+    }
+    // whichever was asleep has just been hit
+    mallet_asleep[j] = false;
+    mallet_rest_ticks[j] = 0;
+    puck_asleep = false;
+    puck_rest_ticks = 0;
+    return true;
+}
+
+template<class Scalar, class Parameters>
+const typename ash::Basic_environment<Scalar, Parameters>::Body&
+ash::Basic_environment<Scalar, Parameters>::get_body(size_t slot) const {
+    if (slot < barrier_slot) {
+        return rink->walls[slot - wall_slot];
+    }
+    if (slot < mallet_slot) {
+        return rink->barriers[slot - barrier_slot];
+    }
+    if (slot < puck_slot) {
+        return mallets[slot - mallet_slot];
+    }
+    return puck;
 }
 
-ash::Environment::State ash::Environment::get_state() const {
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::prepare_contact_cache(
+        Contact_cache& cache, int n, Scalar h) const {
+    const auto& config = get_parameters();
+    // Whatever the actions, the controller cannot push a mallet faster
+    // than v' = |1 - kd*h/m|*v + h/m*kd*mallet_max_velocity, and the puck
+    // only slows down until a mallet hits it. Walls never speed a body up.
+    // A force applied before the step adds to the first substep, as in
+    // contact_free.
+    typedef Bound_scalar<Scalar> Bound;
+    auto& travel = cache.travel;
+    travel = {};
+    Bound dt = static_cast<Bound>(h);
+    for (size_t i = 0; i < mallets.size(); ++i) {
+        Bound inv_mass = static_cast<Bound>(mallets[i].get_inv_mass());
+        using std::abs;
+        Bound damping = abs(1 - config.kd*dt*inv_mass);
+        Bound push = dt*inv_mass*config.kd*config.mallet_max_velocity;
+        Bound speed = bound_norm(mallets[i].get_velocity());
+        Bound pending = bound_norm(mallets[i].get_force());
+        Bound distance = 0;
+        for (int k = 0; k < n; ++k) {
+            speed = damping*speed + push + dt*inv_mass*pending;
+            distance += speed*dt;
+            pending = 0;
+        }
+        travel[mallet_slot + i] = distance + bound_margin;
+    }
+    travel[puck_slot] = (bound_norm(puck.get_velocity()) +
+            bound_norm(puck.get_force())*
+            static_cast<Bound>(puck.get_inv_mass())*dt)*n*dt + bound_margin;
+
+    for (size_t pair = 0; pair < pair_count; ++pair) {
+        auto a = get_body(cached_pairs[pair].a).get_bounding_box();
+        auto b = get_body(cached_pairs[pair].b).get_bounding_box();
+        cache.gaps[pair] = static_cast<Bound>(std::max(
+                std::max(a.x_min - b.x_max, b.x_min - a.x_max),
+                std::max(a.y_min - b.y_max, b.y_min - a.y_max)));
+    }
+    cache.valid = true;
+}
+
+template<class Scalar, class Parameters>
+bool ash::Basic_environment<Scalar, Parameters>::contact_free(const Action& a1,
+        const Action& a2, int n, Scalar h) const {
+    const auto& config = get_parameters();
+    typedef Bound_scalar<Scalar> Bound;
+    const Bound max_p_force = config.kd*config.mallet_max_velocity;
+
+    // Bound on the distance covered by each mallet, following the
+    // integrator with every term in the worst possible direction:
+    // v' = (1 - kd*h/m)*v + h/m*p, with p clamped and growing at most with
+    // the distance travelled away from the target. A force applied before
+    // the step adds to p in the first substep.
+    const Action* actions[] = {&a1, &a2};
+    std::array<AABB,2> mallet_reach;
+    for (size_t i = 0; i < mallets.size(); ++i) {
+        Bound inv_mass = static_cast<Bound>(mallets[i].get_inv_mass());
+        Bound dt = static_cast<Bound>(h);
+        using std::abs;
+        Bound damping = abs(1 - config.kd*dt*inv_mass);
+        Bound error = bound_norm(*actions[i] - mallets[i].get_position());
+        Bound speed = bound_norm(mallets[i].get_velocity());
+        Bound pending = bound_norm(mallets[i].get_force());
+        Bound travel = 0;
+        for (int k = 0; k < n; ++k) {
+            Bound p = std::min(max_p_force,
+                    Bound(config.kp*(error + travel)));
+            speed = damping*speed + dt*inv_mass*(p + pending);
+            travel += speed*dt;
+            pending = 0;
+        }
+        mallet_reach[i] = grow(mallets[i].get_bounding_box(),
+                Scalar(travel + bound_margin));
+        for (const auto& wall : rink->walls) {
+            if (mallet_reach[i].intersects(wall.get_bounding_box())) {
+                return false;
+            }
+        }
+        for (const auto& barrier : rink->barriers) {
+            if (mallet_reach[i].intersects(barrier.get_bounding_box())) {
+                return false;
+            }
+        }
+    }
+
+    // friction never speeds the puck up, a force applied before the step
+    // does in the first substep
+    Bound dt = static_cast<Bound>(h);
+    Bound puck_travel = (bound_norm(puck.get_velocity()) +
+            bound_norm(puck.get_force())*
+            static_cast<Bound>(puck.get_inv_mass())*dt)*n*dt;
+    auto puck_reach = grow(puck.get_bounding_box(),
+            Scalar(puck_travel + bound_margin));
+    for (const auto& wall : rink->walls) {
+        if (puck_reach.intersects(wall.get_bounding_box())) {
+            return false;
+        }
+    }
+    for (const auto& reach : mallet_reach) {
+        if (puck_reach.intersects(reach)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template<class Scalar, class Parameters>
+int ash::Basic_environment<Scalar, Parameters>::adaptive_substeps(
+        const Action& a1, const Action& a2) const {
+    const auto& config = get_parameters();
+    const auto gains = get_pd_gains<Scalar>(config);
+    using std::ceil;
+    // the controller cannot push a mallet beyond mallet_max_velocity, nor
+    // faster than its current acceleration allows
+    const Action* actions[] = {&a1, &a2};
+    Scalar mallet_speed = 0;
+    for (size_t i = 0; i < mallets.size(); ++i) {
+        Scalar v = mallets[i].get_velocity().norm();
+        Scalar a = pd_control(gains, *actions[i], mallets[i]).norm()*
+            mallets[i].get_inv_mass();
+        mallet_speed = std::max(mallet_speed,
+                std::min(Scalar(v + a*config.dt),
+                    std::max(v, Scalar(config.mallet_max_velocity))));
+    }
+    if (collision_detection == Collision_detection::swept) {
+        // the puck takes care of itself
+        return std::clamp(static_cast<int>(std::min<double>(
+                        static_cast<double>(ceil(mallet_speed*config.dt/
+                                config.max_substep_travel())),
+                        config.max_substeps())), 1, config.max_substeps());
+    }
+    // friction and walls only slow the puck down, but a mallet within reach
+    // may hit it
+    Scalar puck_speed = puck.get_velocity().norm();
+    Scalar max_speed = std::max(mallet_speed, puck_speed);
+    for (const auto& mallet : mallets) {
+        Scalar gap = (mallet.get_position() - puck.get_position()).norm() -
+            mallet.get_radius() - puck.get_radius();
+        if (gap < (mallet_speed + puck_speed)*config.dt) {
+            const Scalar w = (1/config.puck_mass)/
+                (1/config.mallet_mass + 1/config.puck_mass);
+            max_speed = std::max(max_speed, Scalar(puck_speed +
+                        w*(1 + config.mallet_puck_restitution)*
+                        (mallet_speed + puck_speed)));
+            break;
+        }
+    }
+    Scalar wanted = ceil(max_speed*config.dt/config.max_substep_travel());
+    return std::clamp(static_cast<int>(std::min<double>(
+                    static_cast<double>(wanted), config.max_substeps())),
+            1, config.max_substeps());
+}
+
+template<class Scalar, class Parameters>
+typename ash::Basic_environment<Scalar, Parameters>::State
+ash::Basic_environment<Scalar, Parameters>::get_state() const {
     State state;
     for (size_t i = 0; i < mallets.size(); ++i) {
         state.mallets[i].position = mallets[i].get_position();
@@ -322,75 +902,622 @@ ash::Environment::State ash::Environment::get_state() const {
     return state;
 }
 
-void ash::Environment::set_state(const State& state) {
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::set_state(
+        const State& state) {
     for (size_t i = 0; i < mallets.size(); ++i) {
         mallets[i].set_position(state.mallets[i].position);
         mallets[i].set_velocity(state.mallets[i].velocity);
     }
     puck.set_position(state.puck.position);
     puck.set_velocity(state.puck.velocity);
+    wake_all();
 }
 
-int ash::Environment::substep(const Action& a1, const Action& a2) {
-    // apply forces to mallets
-    using namespace ::ash::parameters;
+template<class Scalar, class Parameters>
+typename ash::Basic_environment<Scalar, Parameters>::Snapshot
+ash::Basic_environment<Scalar, Parameters>::get_snapshot() const {
+    Snapshot snapshot;
+    const Body* bodies[] = {&mallets[0], &mallets[1], &puck};
+    typename Snapshot::Body_snapshot* out[] = {
+        &snapshot.mallets[0], &snapshot.mallets[1], &snapshot.puck};
+    for (size_t i = 0; i < 3; ++i) {
+        *out[i] = {bodies[i]->get_position(), bodies[i]->get_velocity(),
+            bodies[i]->get_force()};
+    }
+    snapshot.mallet_rest_ticks = mallet_rest_ticks;
+    snapshot.puck_rest_ticks = puck_rest_ticks;
+    snapshot.last_substeps = last_substeps;
+    snapshot.mallet_asleep = mallet_asleep;
+    snapshot.puck_asleep = puck_asleep;
+    snapshot.last_fast_path = last_fast_path;
+    return snapshot;
+}
 
-    Vector_2d force_1 = pd_control(a1, mallets[0]);
-    Vector_2d force_2 = pd_control(a2, mallets[1]);
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::restore(
+        const Snapshot& snapshot) {
+    Body* bodies[] = {&mallets[0], &mallets[1], &puck};
+    const typename Snapshot::Body_snapshot* in[] = {
+        &snapshot.mallets[0], &snapshot.mallets[1], &snapshot.puck};
+    for (size_t i = 0; i < 3; ++i) {
+        bodies[i]->set_position(in[i]->position);
+        bodies[i]->set_velocity(in[i]->velocity);
+        bodies[i]->set_force(in[i]->force);
+    }
+    mallet_rest_ticks = snapshot.mallet_rest_ticks;
+    puck_rest_ticks = snapshot.puck_rest_ticks;
+    last_substeps = snapshot.last_substeps;
+    mallet_asleep = snapshot.mallet_asleep;
+    puck_asleep = snapshot.puck_asleep;
+    last_fast_path = snapshot.last_fast_path;
+}
 
-    mallets[0].apply_force(force_1);
-    mallets[1].apply_force(force_2); 
+template<class Scalar, class Parameters>
+std::uint64_t
+ash::Basic_environment<Scalar, Parameters>::get_state_hash() const {
+    auto state = get_state();
+    const Scalar values[] = {
+        state.mallets[0].position.x, state.mallets[0].position.y,
+        state.mallets[0].velocity.x, state.mallets[0].velocity.y,
+        state.mallets[1].position.x, state.mallets[1].position.y,
+        state.mallets[1].velocity.x, state.mallets[1].velocity.y,
+        state.puck.position.x, state.puck.position.y,
+        state.puck.velocity.x, state.puck.velocity.y};
+    std::uint64_t hash = 14695981039346656037ull;
+    for (Scalar value : values) {
+        // byte by byte, least significant first, whatever the endianness
+        std::uint64_t bits = get_bits(value);
+        for (size_t i = 0; i < sizeof(Scalar); ++i) {
+            hash ^= (bits >> 8*i) & 0xff;
+            hash *= 1099511628211ull;
+        }
+    }
+    return hash;
+}
 
-    // Semi-implicit or symplectic Euler integration
-    Body* bodies[] = {&mallets[0], &mallets[1], &puck};
-    for (auto& body : bodies) {
-        auto position = body->get_position();
-        auto velocity = body->get_velocity();
-
-        // 1.2. friction (only_puck)
-        double velocity_mag = velocity.norm();
-        if (velocity_mag>0 && body==&puck) {
-            double velocity_dec = gravity*puck_mu*substep_dt;
-            velocity_dec = fmin(velocity_mag, velocity_dec);
-            velocity -= velocity_dec/velocity_mag * velocity;
+template<class Scalar, class Parameters>
+template<class A, class B>
+bool ash::Basic_environment<Scalar, Parameters>::handle_collision(A& a, B& b,
+        Scalar restitution, size_t pair, Contact_cache& cache) {
+    const auto& config = get_parameters();
+    const auto& cached = cached_pairs[pair];
+    auto& travel = cache.travel;
+    if (cache.valid && cache.gaps[pair] > travel[cached.a] + travel[cached.b]) {
+        if (contact_stats) {
+            ++(*contact_stats)[pair].skipped;
+        }
+        return false;
+    }
+    if (contact_stats) {
+        ++(*contact_stats)[pair].tested;
+    }
+    if (!broadphase_test(a, b)) {
+        return false;
+    }
+    auto respond = [&](auto& body) {
+        auto collision = collides(body, b);
+        if (!collision) {
+            return false;
+        }
+        if (contact_stats) {
+            ++(*contact_stats)[pair].contacts;
+        }
+        // walls and barriers take no share of the response
+        auto weights = std::is_const_v<A>?
+            Basic_response_weights<Scalar>{0, 1} :
+            response_weights(body.get_inv_mass(), b.get_inv_mass());
+        auto before_a = body.get_position();
+        auto before_b = b.get_position();
+        resolve_collision(*collision, restitution, weights);
+        correct_position(*collision, Scalar(config.slop),
+                Scalar(config.positional_correction), weights);
+        // pushing bodies apart eats into the margins of the other pairs
+        // (walls and barriers stay where they are)
+        if (cache.valid) {
+            if constexpr (!std::is_const_v<A>) {
+                travel[cached.a] +=
+                    bound_norm(body.get_position() - before_a);
+            }
+            travel[cached.b] += bound_norm(b.get_position() - before_b);
+        }
+        return true;
+    };
+    bool contact;
+    if constexpr (std::is_const_v<A>) {
+        // The walls and barriers are shared, so the collision is resolved
+        // against a copy. Their infinite mass leaves it as it was anyway.
+        auto copy = a;
+        contact = respond(copy);
+    }
+    else {
+        contact = respond(a);
+    }
+    if constexpr (std::is_same_v<A, Disk> && std::is_same_v<B, Disk>) {
+        // a hit puck may speed up beyond its bound
+        if (contact) {
+            cache.valid = false;
+        }
+    }
+    return contact;
+}
+
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::set_static_collision(
+        Static_collision static_collision) {
+    this->static_collision = static_collision;
+    if (static_collision == Static_collision::field) {
+        static_fields = &get_static_fields();
+    }
+    if constexpr (std::is_same_v<Scalar, double>) {
+        if (static_collision == Static_collision::packed) {
+            packed_rink = &get_packed_rink();
+        }
+    }
+}
+
+template<class Scalar, class Parameters>
+const typename ash::Basic_environment<Scalar, Parameters>::Static_fields&
+ash::Basic_environment<Scalar, Parameters>::get_static_fields() const {
+    const auto& config = get_parameters();
+    // everything the rink and the fields depend on
+    typedef std::array<double,6> Field_key;
+    Field_key key = {config.field_length, config.field_width,
+        config.goal_width, config.wall_thickness, config.puck_radius,
+        config.static_field_resolution};
+    return get_shared<Static_fields>(key, [this, &config] {
+        std::vector<AABB> boxes;
+        for (const auto& wall : rink->walls) {
+            boxes.push_back(wall.get_bounding_box());
+        }
+        auto walls_and_barriers = boxes;
+        for (const auto& barrier : rink->barriers) {
+            walls_and_barriers.push_back(barrier.get_bounding_box());
+        }
+        // the whole rink, with room for a puck on its way into a goal
+        AABB bounds;
+        bounds.x_max = config.field_length/2 + config.wall_thickness +
+            4*config.puck_radius;
+        bounds.x_min = -bounds.x_max;
+        bounds.y_max = config.field_width/2 + config.wall_thickness +
+            2*config.puck_radius;
+        bounds.y_min = -bounds.y_max;
+        return Static_fields{
+            Distance_field(boxes, bounds, config.static_field_resolution),
+            Distance_field(walls_and_barriers, bounds,
+                config.static_field_resolution)};
+    });
+}
+
+template<class Scalar, class Parameters>
+const typename ash::Basic_environment<Scalar, Parameters>::Packed_rink&
+ash::Basic_environment<Scalar, Parameters>::get_packed_rink() const {
+    const auto& config = get_parameters();
+    // everything the rink depends on
+    typedef std::array<double,4> Rink_key;
+    Rink_key key = {config.field_length, config.field_width,
+        config.goal_width, config.wall_thickness};
+    return get_shared<Packed_rink>(key, [this] {
+        std::vector<ash::AABB> boxes;
+        for (const auto& wall : rink->walls) {
+            const auto& box = wall.get_bounding_box();
+            boxes.push_back({double(box.x_min), double(box.x_max),
+                    double(box.y_min), double(box.y_max)});
+        }
+        auto walls_and_barriers = boxes;
+        for (const auto& barrier : rink->barriers) {
+            const auto& box = barrier.get_bounding_box();
+            walls_and_barriers.push_back({double(box.x_min),
+                    double(box.x_max), double(box.y_min), double(box.y_max)});
+        }
+        return Packed_rink{Packed_boxes(boxes),
+            Packed_boxes(walls_and_barriers)};
+    });
+}
+
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::collide_mallets_with_rink(
+        Contact_cache& cache) {
+    const auto& config = get_parameters();
+    if constexpr (std::is_same_v<Scalar, double>) {
+        if (static_collision == Static_collision::packed) {
+            for (size_t j = 0; j < mallets.size(); ++j) {
+                if (!mallet_asleep[j]) {
+                    collide_with_packed(packed_rink->mallets, mallets[j],
+                            config.mallet_wall_restitution);
+                }
+            }
+            return;
+        }
+    }
+    if (static_collision == Static_collision::field) {
+        for (auto& mallet : mallets) {
+            size_t j = &mallet - &mallets[0];
+            if (mallet_asleep[j]) {
+                continue;
+            }
+            if (collide_with_field(static_fields->mallets, mallet,
+                        config.mallet_wall_restitution)) {
+                continue;
+            }
+            for (size_t i = 0; i < rink->walls.size(); ++i) {
+                handle_collision(rink->walls[i], mallet,
+                        config.mallet_wall_restitution, i*2 + j, cache);
+            }
+            for (size_t i = 0; i < rink->barriers.size(); ++i) {
+                handle_collision(rink->barriers[i], mallet,
+                        config.mallet_wall_restitution, 12 + i*2 + j, cache);
+            }
+        }
+        return;
+    }
+    for (size_t i = 0; i < rink->walls.size(); ++i) {
+        for (size_t j = 0; j < mallets.size(); ++j) {
+            if (mallet_asleep[j]) {
+                continue;
+            }
+            handle_collision(rink->walls[i], mallets[j],
+                    config.mallet_wall_restitution, i*2 + j, cache);
+        }
+    }
+    for (size_t i = 0; i < rink->barriers.size(); ++i) {
+        for (size_t j = 0; j < mallets.size(); ++j) {
+            if (mallet_asleep[j]) {
+                continue;
+            }
+            handle_collision(rink->barriers[i], mallets[j],
+                    config.mallet_wall_restitution, 12 + i*2 + j, cache);
+        }
+    }
+}
+
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::collide_puck_with_rink(
+        Contact_cache& cache) {
+    const auto& config = get_parameters();
+    if (puck_asleep) {
+        return;
+    }
+    if (static_collision == Static_collision::field &&
+            collide_with_field(static_fields->puck, puck,
+                config.puck_wall_restitution)) {
+        return;
+    }
+    if constexpr (std::is_same_v<Scalar, double>) {
+        if (static_collision == Static_collision::packed) {
+            collide_with_packed(packed_rink->puck, puck,
+                    config.puck_wall_restitution);
+            return;
         }
+    }
+    for (size_t i = 0; i < rink->walls.size(); ++i) {
+        handle_collision(rink->walls[i], puck, config.puck_wall_restitution,
+                18 + i, cache);
+    }
+}
 
-        // 1. update velocity
-        // 1.1. accumulated force
-        velocity += body->get_force()*body->get_inv_mass()*substep_dt;
- 
+template<class Scalar, class Parameters>
+bool ash::Basic_environment<Scalar, Parameters>::collide_with_field(
+        const Distance_field& field, Disk& disk, Scalar restitution) {
+    const auto& config = get_parameters();
+    auto position = disk.get_position();
+    if (!field.covers(position)) {
+        return false;
+    }
+    // most of the time the disk is far from every wall
+    if (field.distance(position) >= disk.get_radius()) {
+        return true;
+    }
+    auto sample = field.lookup(position);
+    Scalar penetration = disk.get_radius() - sample.distance;
+    // resolve_collision and correct_position against a static body
+    auto velocity = disk.get_velocity();
+    Scalar v_n = sample.normal.dot(velocity);
+    if (v_n < 0) {
+        velocity -= ((1+restitution)*v_n) * sample.normal;
+        disk.set_velocity(velocity);
+    }
+    if (penetration >= config.slop) {
+        position += config.positional_correction*penetration * sample.normal;
+        disk.set_position(position);
+    }
+    return true;
+}
 
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::collide_with_packed(
+        const Packed_boxes& boxes, Disk& disk, Scalar restitution) {
+    if constexpr (std::is_same_v<Scalar, double>) {
+        const auto& config = get_parameters();
+        Packed_boxes::Contacts contacts;
+        boxes.collide(disk.get_position(), disk.get_radius(), contacts);
+        auto mask = contacts.mask;
+        while (mask != 0) {
+            auto i = __builtin_ctz(mask);
+            mask &= mask - 1;
+            // as handle_collision, against a copy
+            auto box = size_t(i) < rink->walls.size()? rink->walls[i] :
+                rink->barriers[i - rink->walls.size()];
+            Collision collision;
+            collision.a = &box;
+            collision.b = &disk;
+            collision.normal = Vector_2d(contacts.normal_x[i],
+                    contacts.normal_y[i]);
+            collision.penetration = contacts.penetration[i];
+            auto before = disk.get_position();
+            resolve_collision(collision, restitution);
+            correct_position(collision, Scalar(config.slop),
+                    Scalar(config.positional_correction));
+            if (!(disk.get_position() == before)) {
+                boxes.collide(disk.get_position(), disk.get_radius(), contacts);
+                mask = contacts.mask & ~((2u << i) - 1);
+            }
+        }
+    }
+}
 
-        // 2. update position
-        position += velocity*substep_dt;
+template<class Scalar, class Parameters>
+int ash::Basic_environment<Scalar, Parameters>::substep(const Action& a1,
+        const Action& a2, Scalar h, const Mallet_steppers& steppers,
+        Contact_cache& cache) {
+    Vector_2d puck_start = puck.get_position();
+    std::array<Vector_2d,2> mallet_start = {
+        mallets[0].get_position(), mallets[1].get_position()};
 
-        // 3. update body's internal state, reset force
-        body->set_position(position);
-        body->set_velocity(velocity);
-        body->reset_force();
+    integrate(a1, a2, h, steppers);
 
+    if (collision_detection == Collision_detection::swept) {
+        sweep_puck(puck_start, mallet_start, h);
     }
 
     // detect and resolve collisions
-    for (auto& wall : walls) {
-        for (auto& mallet : mallets) {
-            handle_collision(wall, mallet, mallet_wall_restitution);
+    collide_mallets_with_rink(cache);
+    if (collision_detection == Collision_detection::swept) {
+        // a mallet may push the puck into a wall, so the push is swept too
+        // and the walls get the last word
+        for (size_t j = 0; j < mallets.size(); ++j) {
+            auto before = puck.get_position();
+            collide_mallet_with_puck(j, cache);
+            auto push = puck.get_position() - before;
+            if (push.is_zero()) {
+                continue;
+            }
+            if (auto impact = sweep_puck_vs_walls(before, push)) {
+                puck.set_position(before + impact->time*push);
+            }
         }
+        collide_puck_with_rink(cache);
     }
-    for (auto& barrier : barriers) {
-        for (auto& mallet : mallets) {
-            handle_collision(barrier, mallet, mallet_wall_restitution);
+    else {
+        collide_puck_with_rink(cache);
+        for (size_t j = 0; j < mallets.size(); ++j) {
+            collide_mallet_with_puck(j, cache);
         }
     }
-    for (auto& wall : walls) {
-        handle_collision(wall, puck, puck_wall_restitution);
+
+    return check_goal();
+}
+
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::integrate(const Action& a1,
+        const Action& a2, Scalar h, const Mallet_steppers& steppers) {
+    const auto& config = get_parameters();
+
+    switch (integrator) {
+        case Integrator::velocity_verlet:
+            integrate_verlet(a1, a2, h);
+            return;
+        case Integrator::runge_kutta:
+            integrate_runge_kutta(a1, a2, h);
+            return;
+        default:
+            break;
+    }
+
+    // Semi-implicit or symplectic Euler integration
+    // 1. mallets: the controller and the accumulated force
+    const Action* actions[] = {&a1, &a2};
+    for (size_t i = 0; i < mallets.size(); ++i) {
+        if (!mallet_asleep[i]) {
+            const auto& stepper = steppers.mallets[i];
+            auto velocity = stepper.velocity(*actions[i],
+                    mallets[i].get_position(), mallets[i].get_velocity(),
+                    mallets[i].get_force());
+            mallets[i].set_position(stepper.position(
+                        mallets[i].get_position(), velocity));
+            mallets[i].set_velocity(velocity);
+        }
+        mallets[i].reset_force();
+    }
+
+    // 2. puck: friction and the accumulated force
+    if (puck_asleep) {
+        puck.reset_force();
+        return;
     }
-    for (auto& mallet : mallets) {
-        handle_collision(mallet, puck, mallet_puck_restitution);
+    auto position = puck.get_position();
+    auto velocity = puck.get_velocity();
+    Scalar velocity_mag = velocity.norm();
+    if (velocity_mag>0) {
+        Scalar velocity_dec = Scalar(config.gravity*config.puck_mu)*h;
+        using std::fmin;
+        velocity_dec = fmin(velocity_mag, velocity_dec);
+        velocity -= velocity_dec/velocity_mag * velocity;
     }
+    velocity = accelerate(velocity, puck.get_force(), puck.get_inv_mass(), h);
+    position += velocity*h;
+    puck.set_position(position);
+    puck.set_velocity(velocity);
+    puck.reset_force();
+}
 
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::integrate_verlet(
+        const Action& a1, const Action& a2, Scalar h) {
+    const auto& config = get_parameters();
+    const auto gains = get_pd_gains<Scalar>(config);
+    // The PD force depends on the velocity, so the acceleration at the end
+    // of the substep is evaluated with a predicted (Euler) velocity. A force
+    // applied before the step acts on the whole first substep, which gives
+    // it the same impulse as in integrate.
+    const Action* actions[] = {&a1, &a2};
+    for (size_t i = 0; i < mallets.size(); ++i) {
+        auto position = mallets[i].get_position();
+        auto velocity = mallets[i].get_velocity();
+        Scalar inv_mass = mallets[i].get_inv_mass();
+        auto pending = mallets[i].get_force();
+        auto accel = (pending +
+                pd_control(gains, *actions[i], position, velocity))*inv_mass;
+        position += velocity*h + accel*(0.5*h*h);
+        auto predicted = velocity + accel*h;
+        auto next_accel = (pending +
+                pd_control(gains, *actions[i], position, predicted))*inv_mass;
+        velocity += (accel + next_accel)*(0.5*h);
+        mallets[i].set_position(position);
+        mallets[i].set_velocity(velocity);
+        mallets[i].reset_force();
+    }
+    advance_puck(h);
+}
+
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::integrate_runge_kutta(
+        const Action& a1, const Action& a2, Scalar h) {
+    const auto& config = get_parameters();
+    const auto gains = get_pd_gains<Scalar>(config);
+    // a force applied before the step acts on the whole first substep, as
+    // in integrate_verlet
+    const Action* actions[] = {&a1, &a2};
+    for (size_t i = 0; i < mallets.size(); ++i) {
+        const auto& t = *actions[i];
+        auto x = mallets[i].get_position();
+        auto v = mallets[i].get_velocity();
+        Scalar inv_mass = mallets[i].get_inv_mass();
+        auto f = mallets[i].get_force();
+        auto k1_x = v;
+        auto k1_v = (f + pd_control(gains, t, x, v))*inv_mass;
+        auto k2_x = v + k1_v*(0.5*h);
+        auto k2_v = (f + pd_control(gains, t, x + k1_x*(0.5*h), k2_x))*
+            inv_mass;
+        auto k3_x = v + k2_v*(0.5*h);
+        auto k3_v = (f + pd_control(gains, t, x + k2_x*(0.5*h), k3_x))*
+            inv_mass;
+        auto k4_x = v + k3_v*h;
+        auto k4_v = (f + pd_control(gains, t, x + k3_x*h, k4_x))*inv_mass;
+        x += (k1_x + 2*k2_x + 2*k3_x + k4_x)*(h/6);
+        v += (k1_v + 2*k2_v + 2*k3_v + k4_v)*(h/6);
+        mallets[i].set_position(x);
+        mallets[i].set_velocity(v);
+        mallets[i].reset_force();
+    }
+    advance_puck(h);
+}
+
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::advance_puck(Scalar h) {
+    const auto& config = get_parameters();
+    // a force applied before the step gives the same kick as in integrate,
+    // then friction takes over
+    auto velocity = puck.get_velocity() +
+        puck.get_force()*puck.get_inv_mass()*h;
+    puck.reset_force();
+    Scalar speed = velocity.norm();
+    if (speed == 0) {
+        return;
+    }
+    const Scalar deceleration = config.gravity*config.puck_mu;
+    auto direction = velocity/speed;
+    auto position = puck.get_position();
+    if (speed > deceleration*h) {
+        position += (speed*h - 0.5*deceleration*h*h)*direction;
+        velocity = (speed - deceleration*h)*direction;
+    }
+    else {
+        // stops within the substep
+        position += (0.5*speed*speed/deceleration)*direction;
+        velocity = Vector_2d(0, 0);
+    }
+    puck.set_position(position);
+    puck.set_velocity(velocity);
+}
+
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::integrate_free(
+        const Action& a1, const Action& a2, int n, Scalar h,
+        const Mallet_steppers& steppers) {
+    const auto& config = get_parameters();
+    // The bodies do not interact, so each of them goes through all the
+    // substeps in one go. The arithmetic is the same as in integrate: a
+    // force applied before the step (through apply_force) counts in the
+    // first substep only, later substeps accumulate on a zero vector, and
+    // no force is left over afterwards.
+    const Action* actions[] = {&a1, &a2};
+    for (size_t i = 0; i < mallets.size(); ++i) {
+        if (mallet_asleep[i]) {
+            mallets[i].reset_force();
+            continue;
+        }
+        const auto& stepper = steppers.mallets[i];
+        auto position = mallets[i].get_position();
+        auto velocity = mallets[i].get_velocity();
+        auto pending = mallets[i].get_force();
+        for (int k = 0; k < n; ++k) {
+            auto next_velocity = stepper.velocity(*actions[i], position,
+                    velocity, pending);
+            auto next_position = stepper.position(position, next_velocity);
+            if constexpr (std::numeric_limits<Scalar>::is_exact) {
+                // a mallet that has come to rest on its target stays
+                // there for the remaining substeps
+                if (next_velocity == velocity && next_position == position &&
+                        pending == Vector_2d()) {
+                    break;
+                }
+            }
+            velocity = next_velocity;
+            position = next_position;
+            pending = Vector_2d();
+        }
+        mallets[i].set_position(position);
+        mallets[i].set_velocity(velocity);
+        mallets[i].reset_force();
+    }
+
+    if (puck_asleep) {
+        puck.reset_force();
+        return;
+    }
+    auto position = puck.get_position();
+    auto velocity = puck.get_velocity();
+    Scalar inv_mass = puck.get_inv_mass();
+    auto force = puck.get_force();
+    for (int k = 0; k < n; ++k) {
+        if constexpr (std::numeric_limits<Scalar>::is_exact) {
+            // friction stops the puck exactly, and then nothing moves it
+            if (velocity.is_zero() && force.is_zero()) {
+                break;
+            }
+        }
+        Scalar velocity_mag = velocity.norm();
+        if (velocity_mag>0) {
+            Scalar velocity_dec = Scalar(config.gravity*config.puck_mu)*h;
+            using std::fmin;
+            velocity_dec = fmin(velocity_mag, velocity_dec);
+            velocity -= velocity_dec/velocity_mag * velocity;
+        }
+        velocity = accelerate(velocity, force, inv_mass, h);
+        position += velocity*h;
+        force = Vector_2d();
+    }
+    puck.set_position(position);
+    puck.set_velocity(velocity);
+    puck.reset_force();
+}
+
+template<class Scalar, class Parameters>
+int ash::Basic_environment<Scalar, Parameters>::check_goal() const {
+    const auto& config = get_parameters();
     // check if puck has entered one of the goals
-    double goal_threshold = field_length/2 + puck_radius;
+    Scalar goal_threshold = config.field_length/2 + config.puck_radius;
     if (puck.get_position().x < -goal_threshold) {
         return 1;
     }
@@ -400,15 +1527,129 @@ int ash::Environment::substep(const Action& a1, const Action& a2) {
     return -1;
 }
 
-void ash::Environment::handle_collision(Body& a, Body& b,
-        double restitution) {
-    using namespace ::ash::parameters;
-    if (!broadphase_test(a, b)) {
-        return;
+template<class Scalar, class Parameters>
+void ash::Basic_environment<Scalar, Parameters>::sweep_puck(
+        const Vector_2d& start, const std::array<Vector_2d, 2>& mallet_start,
+        Scalar h) {
+    const auto& config = get_parameters();
+    // t is the fraction of the substep simulated so far; mallets are assumed
+    // to move in a straight line during the substep
+    auto position = start;
+    Scalar t = 0;
+    for (int i = 0; i < config.max_swept_impacts && t < 1; ++i) {
+        auto velocity = puck.get_velocity();
+        auto displacement = (1 - t)*h*velocity;
+        Disk* hit_mallet = nullptr;
+        auto first = sweep_puck_vs_walls(position, displacement);
+        for (size_t j = 0; j < mallets.size(); ++j) {
+            auto travel = mallets[j].get_position() - mallet_start[j];
+            auto mallet_position = mallet_start[j] + t*travel;
+            auto impact = sweep_disk(position - mallet_position,
+                    Scalar(config.puck_radius + config.mallet_radius),
+                    displacement - (1 - t)*travel);
+            if (impact && (!first || impact->time < first->time)) {
+                first = impact;
+                hit_mallet = &mallets[j];
+            }
+        }
+        if (!first) {
+            position += displacement;
+            t = 1;
+            break;
+        }
+        position += first->time*displacement;
+        t += (1 - t)*first->time;
+
+        // same response as resolve_collision, with the obstacle as body a
+        const auto& normal = first->normal;
+        if (hit_mallet) {
+            auto mallet_velocity = hit_mallet->get_velocity();
+            Scalar v_n = normal.dot(velocity - mallet_velocity);
+            if (v_n < 0) {
+                Scalar den = hit_mallet->get_inv_mass() + puck.get_inv_mass();
+                Scalar w1 = hit_mallet->get_inv_mass() / den;
+                Scalar w2 = puck.get_inv_mass() / den;
+                Scalar e = config.mallet_puck_restitution;
+                mallet_velocity += (w1*(1+e)*v_n) * normal;
+                velocity -= (w2*(1+e)*v_n) * normal;
+                hit_mallet->set_velocity(mallet_velocity);
+            }
+        }
+        else {
+            Scalar v_n = normal.dot(velocity);
+            if (v_n < 0) {
+                velocity -= ((1+config.puck_wall_restitution)*v_n) * normal;
+            }
+        }
+        puck.set_velocity(velocity);
     }
-    if (auto collision = collides(a, b)) {
-        resolve_collision(*collision, restitution);
-        correct_position(*collision, slop, positional_correction);
+    // whatever is left of the substep after too many impacts is dropped
+    puck.set_position(position);
+}
+
+template<class Scalar, class Parameters>
+std::optional<ash::Basic_impact<Scalar>>
+ash::Basic_environment<Scalar, Parameters>::sweep_puck_vs_walls(
+        const Vector_2d& position, const Vector_2d& displacement) const {
+    const auto& config = get_parameters();
+    // box around the whole sweep, to skip the walls that are out of reach
+    auto end = position + displacement;
+    AABB reach;
+    reach.x_min = std::min(position.x, end.x) - config.puck_radius;
+    reach.x_max = std::max(position.x, end.x) + config.puck_radius;
+    reach.y_min = std::min(position.y, end.y) - config.puck_radius;
+    reach.y_max = std::max(position.y, end.y) + config.puck_radius;
+    std::optional<Impact> first;
+    for (const auto& wall : rink->walls) {
+        auto box = wall.get_bounding_box();
+        if (!reach.intersects(box)) {
+            continue;
+        }
+        auto impact = sweep_disk(position, Scalar(config.puck_radius),
+                displacement, box);
+        if (impact && (!first || impact->time < first->time)) {
+            first = impact;
+        }
     }
+    return first;
 }
 
+template class ash::Basic_body<double>;
+template class ash::Basic_body<float>;
+template class ash::Basic_body<ash::Fixed>;
+template class ash::Basic_body<ash::Dual_scalar>;
+template class ash::Basic_environment<double>;
+template class ash::Basic_environment<float>;
+template class ash::Basic_environment<ash::Fixed>;
+template class ash::Basic_environment<ash::Dual_scalar>;
+template class ash::Basic_environment<double, ash::Runtime_parameters>;
+template class ash::Basic_environment<double,
+         ash::Constant_parameters<ash::high_rate_parameters>>;
+template class ash::Basic_environment<double,
+         ash::Constant_parameters<ash::rollout_parameters>>;
+
+#define ASH_INSTANTIATE_COLLISIONS(Scalar) \
+    template std::optional<ash::Basic_collision<Scalar>> ash::collides( \
+            Basic_box<Scalar>&, Basic_box<Scalar>&); \
+    template std::optional<ash::Basic_collision<Scalar>> ash::collides( \
+            Basic_box<Scalar>&, Basic_disk<Scalar>&); \
+    template std::optional<ash::Basic_collision<Scalar>> ash::collides( \
+            Basic_disk<Scalar>&, Basic_box<Scalar>&); \
+    template std::optional<ash::Basic_collision<Scalar>> ash::collides( \
+            Basic_disk<Scalar>&, Basic_disk<Scalar>&); \
+    template std::optional<ash::Basic_collision<Scalar>> ash::collides( \
+            Basic_body<Scalar>&, Basic_body<Scalar>&); \
+    template ash::Basic_response_weights<Scalar> ash::response_weights( \
+            Scalar, Scalar); \
+    template void ash::resolve_collision(Basic_collision<Scalar>&, Scalar); \
+    template void ash::resolve_collision(Basic_collision<Scalar>&, Scalar, \
+            const Basic_response_weights<Scalar>&); \
+    template void ash::correct_position(Basic_collision<Scalar>&, Scalar, \
+            Scalar); \
+    template void ash::correct_position(Basic_collision<Scalar>&, Scalar, \
+            Scalar, const Basic_response_weights<Scalar>&);
+
+ASH_INSTANTIATE_COLLISIONS(double)
+ASH_INSTANTIATE_COLLISIONS(float)
+ASH_INSTANTIATE_COLLISIONS(ash::Fixed)
+ASH_INSTANTIATE_COLLISIONS(ash::Dual_scalar)
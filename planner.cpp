@@ -0,0 +1,161 @@
+#include "planner.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+namespace {
+
+constexpr double speed_weight = 0.05;
+constexpr double goal_bonus = 1;
+constexpr double own_goal_penalty = 10;
+// length of the first step of the gradient planner, over all the targets
+constexpr double initial_step = 0.1;
+// standard deviation of the perturbations of the sampling planner
+constexpr double sampling_spread = 0.05;
+
+// plan_cost, in any scalar type: the environment starts from the state of
+// the plan
+template<class Environment>
+typename Environment::Scalar rollout_cost(Environment& env, int player,
+        const std::array<typename Environment::Action,ash::plan_length>&
+        targets) {
+    typedef typename Environment::Scalar Scalar;
+    typedef typename Environment::Action Action;
+    const auto& config = env.get_parameters();
+    // towards the goal of the opponent
+    double direction = player == 0? 1 : -1;
+    Action goal(direction*config.field_length/2, 0);
+    Action hold = env.get_mallets()[1 - player].get_position();
+    Scalar reach = std::numeric_limits<Scalar>::infinity();
+    for (const auto& target : targets) {
+        int winner = player == 0? env.step(target, hold) :
+            env.step(hold, target);
+        if (winner != -1) {
+            return winner == player? Scalar(-goal_bonus) :
+                Scalar(own_goal_penalty);
+        }
+        using std::fmin;
+        reach = fmin(reach, (env.get_mallets()[player].get_position() -
+                    env.get_puck().get_position()).norm());
+    }
+    const auto& puck = env.get_puck();
+    return (puck.get_position() - goal).norm() + reach -
+        speed_weight*direction*puck.get_velocity().x;
+}
+
+ash::Dual_environment::State to_dual(const ash::Environment::State& state) {
+    typedef ash::Dual_environment::Action Action;
+    ash::Dual_environment::State out;
+    for (size_t i = 0; i < 2; ++i) {
+        out.mallets[i].position = Action(state.mallets[i].position);
+        out.mallets[i].velocity = Action(state.mallets[i].velocity);
+    }
+    out.puck.position = Action(state.puck.position);
+    out.puck.velocity = Action(state.puck.velocity);
+    return out;
+}
+
+}
+
+
+double ash::plan_cost(const Environment::State& state, int player,
+        const Plan& plan) {
+    Environment env;
+    env.set_state(state);
+    return rollout_cost(env, player, plan);
+}
+
+ash::Plan ash::initial_plan(const Environment::State& state) {
+    Plan out;
+    out.fill(state.puck.position);
+    return out;
+}
+
+ash::Plan ash::shift_plan(const Plan& plan) {
+    Plan out;
+    std::copy(plan.begin() + 1, plan.end(), out.begin());
+    out.back() = plan.back();
+    return out;
+}
+
+ash::Gradient_planner::Gradient_planner(int player, int iterations) :
+    player(player), iterations(iterations)
+{
+}
+
+double ash::Gradient_planner::get_cost_gradient(
+        const Environment::State& state, const Plan& plan,
+        Dual_scalar::Gradient& gradient) const {
+    Dual_environment env;
+    env.set_state(to_dual(state));
+    std::array<Dual_environment::Action,plan_length> targets;
+    for (size_t i = 0; i < plan_length; ++i) {
+        targets[i].x = Dual_scalar::variable(plan[i].x, 2*i);
+        targets[i].y = Dual_scalar::variable(plan[i].y, 2*i + 1);
+    }
+    auto cost = rollout_cost(env, player, targets);
+    gradient = cost.get_gradient();
+    return cost.get_value();
+}
+
+ash::Plan ash::Gradient_planner::improve(const Environment::State& state,
+        Plan plan) const {
+    Dual_scalar::Gradient gradient;
+    double cost = get_cost_gradient(state, plan, gradient);
+    double step = initial_step;
+    for (int i = 0; i < iterations; ++i) {
+        double norm = 0;
+        for (double derivative : gradient) {
+            norm += derivative*derivative;
+        }
+        norm = std::sqrt(norm);
+        // nothing the mallet does changes the cost (such as when the
+        // puck is already on its way into the goal)
+        if (norm == 0) {
+            break;
+        }
+        Plan candidate = plan;
+        for (size_t k = 0; k < plan_length; ++k) {
+            candidate[k] -= step/norm*Vector_2d(gradient[2*k],
+                    gradient[2*k + 1]);
+        }
+        Dual_scalar::Gradient candidate_gradient;
+        double candidate_cost = get_cost_gradient(state, candidate,
+                candidate_gradient);
+        if (candidate_cost < cost) {
+            plan = candidate;
+            cost = candidate_cost;
+            gradient = candidate_gradient;
+            step *= 1.5;
+        }
+        else {
+            step /= 2;
+        }
+    }
+    return plan;
+}
+
+ash::Sampling_planner::Sampling_planner(int player, int samples,
+        unsigned seed) :
+    player(player), samples(samples), rng(seed)
+{
+}
+
+ash::Plan ash::Sampling_planner::improve(const Environment::State& state,
+        Plan plan) {
+    std::normal_distribution<double> noise(0, sampling_spread);
+    double cost = plan_cost(state, player, plan);
+    for (int i = 0; i < samples; ++i) {
+        Plan candidate = plan;
+        for (auto& target : candidate) {
+            target += Vector_2d(noise(rng), noise(rng));
+        }
+        double candidate_cost = plan_cost(state, player, candidate);
+        if (candidate_cost < cost) {
+            plan = candidate;
+            cost = candidate_cost;
+        }
+    }
+    return plan;
+}
@@ -0,0 +1,205 @@
+#include "benchmark_support.hpp"
+#include "planner.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef ash::benchmark::Clock Clock;
+typedef ash::Environment::State State;
+using ash::benchmark::percentile;
+
+// Player 0 somewhere in its half, with the puck drifting within reach and
+// the opponent somewhere in the other half.
+State random_state(std::mt19937& rng) {
+    using namespace ::ash::parameters;
+    std::uniform_real_distribution<double> x(0.1, field_length/2 - 0.1);
+    std::uniform_real_distribution<double> y(-field_width/2 + 0.1,
+            field_width/2 - 0.1);
+    std::uniform_real_distribution<double> offset(-0.3, 0.3);
+    std::uniform_real_distribution<double> drift(-0.5, 0.5);
+    State state;
+    state.mallets[0].position = ash::Vector_2d(-x(rng), y(rng));
+    state.mallets[1].position = ash::Vector_2d(x(rng), y(rng));
+    for (auto& mallet : state.mallets) {
+        mallet.velocity = ash::Vector_2d(0, 0);
+    }
+    auto puck = state.mallets[0].position +
+        ash::Vector_2d(std::abs(offset(rng)) + 0.1, offset(rng));
+    puck.y = ash::clamp(puck.y, -field_width/2 + puck_radius,
+            field_width/2 - puck_radius);
+    state.puck.position = puck;
+    state.puck.velocity = ash::Vector_2d(drift(rng), drift(rng));
+    return state;
+}
+
+// Relative difference between the derivatives of the cost and central
+// differences of it, one per target coordinate. Central differences are
+// meaningless across a change of branch (the mallet touching the puck one
+// substep earlier), hence the percentiles.
+std::vector<double> check_plan_gradient(const std::vector<State>& states) {
+    constexpr double h = 1e-6;
+    ash::Gradient_planner planner(0);
+    std::vector<double> errors;
+    for (const auto& state : states) {
+        auto plan = ash::initial_plan(state);
+        ash::Dual_scalar::Gradient gradient;
+        planner.get_cost_gradient(state, plan, gradient);
+        for (size_t i = 0; i < 2*ash::plan_length; ++i) {
+            auto plus = plan, minus = plan;
+            (i % 2 == 0? plus[i/2].x : plus[i/2].y) += h;
+            (i % 2 == 0? minus[i/2].x : minus[i/2].y) -= h;
+            double numeric = (ash::plan_cost(state, 0, plus) -
+                    ash::plan_cost(state, 0, minus))/(2*h);
+            double scale = std::max(1.0, std::abs(numeric));
+            errors.push_back(std::abs(gradient[i] - numeric)/scale);
+        }
+    }
+    return errors;
+}
+
+// Same, for the position of the puck after 10 ticks with respect to the
+// initial state (positions and velocities of the three bodies).
+std::vector<double> check_state_gradient(const std::vector<State>& states) {
+    typedef ash::Dual_environment::State Dual_state;
+    typedef ash::Dual_scalar Dual;
+    constexpr double h = 1e-7;
+    constexpr int ticks = 10;
+    auto final_puck = [](const State& state) {
+        ash::Environment env;
+        env.set_state(state);
+        for (int t = 0; t < ticks; ++t) {
+            env.step(state.mallets[0].position + ash::Vector_2d(0.3, 0),
+                    state.mallets[1].position);
+        }
+        return env.get_puck().get_position();
+    };
+    std::vector<double> errors;
+    for (const auto& state : states) {
+        // the twelve numbers of the state, seeded as inputs 0 to 11
+        std::array<const State::BodyStatus*,3> bodies = {&state.mallets[0],
+            &state.mallets[1], &state.puck};
+        Dual_state dual_state;
+        std::array<Dual_state::BodyStatus*,3> dual_bodies = {
+            &dual_state.mallets[0], &dual_state.mallets[1],
+            &dual_state.puck};
+        for (size_t b = 0; b < 3; ++b) {
+            const auto& body = *bodies[b];
+            auto& dual = *dual_bodies[b];
+            dual.position.x = Dual::variable(body.position.x, 4*b);
+            dual.position.y = Dual::variable(body.position.y, 4*b + 1);
+            dual.velocity.x = Dual::variable(body.velocity.x, 4*b + 2);
+            dual.velocity.y = Dual::variable(body.velocity.y, 4*b + 3);
+        }
+        ash::Dual_environment env;
+        env.set_state(dual_state);
+        for (int t = 0; t < ticks; ++t) {
+            env.step(dual_state.mallets[0].position +
+                    ash::Dual_environment::Action(0.3, 0),
+                    dual_state.mallets[1].position);
+        }
+        const auto& puck = env.get_puck().get_position();
+        for (size_t i = 0; i < 12; ++i) {
+            auto plus = state, minus = state;
+            auto component = [i](State& s) -> double& {
+                auto& body = i < 4? s.mallets[0] : i < 8? s.mallets[1] :
+                    s.puck;
+                switch (i % 4) {
+                    case 0: return body.position.x;
+                    case 1: return body.position.y;
+                    case 2: return body.velocity.x;
+                    default: return body.velocity.y;
+                }
+            };
+            component(plus) += h;
+            component(minus) -= h;
+            auto numeric = (final_puck(plus) - final_puck(minus))/(2*h);
+            for (auto [derivative, expected] : {
+                    std::pair{puck.x.get_derivative(i), numeric.x},
+                    std::pair{puck.y.get_derivative(i), numeric.y}}) {
+                double scale = std::max(1.0, std::abs(expected));
+                errors.push_back(std::abs(derivative - expected)/scale);
+            }
+        }
+    }
+    return errors;
+}
+
+struct Result {
+    double mean_cost;
+    double ms_per_plan;
+};
+
+template<class Planner>
+Result measure(Planner& planner, const std::vector<State>& states) {
+    std::vector<ash::Plan> plans;
+    plans.reserve(states.size());
+    auto start = Clock::now();
+    for (const auto& state : states) {
+        plans.push_back(planner.improve(state, ash::initial_plan(state)));
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    Result result = {0, 1e3*elapsed.count()/states.size()};
+    for (size_t i = 0; i < states.size(); ++i) {
+        result.mean_cost += ash::plan_cost(states[i], 0, plans[i])/
+            states.size();
+    }
+    return result;
+}
+
+void print(const char* name, int budget, const Result& result) {
+    std::cout << std::setw(10) << name
+              << std::setw(8) << budget
+              << std::fixed << std::setprecision(3)
+              << std::setw(12) << result.ms_per_plan
+              << std::setw(12) << result.mean_cost
+              << std::defaultfloat << std::endl;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t samples = argc > 1? std::stoul(argv[1]) : 200;
+    std::mt19937 rng(1);
+    std::vector<State> states;
+    for (size_t i = 0; i < samples; ++i) {
+        states.push_back(random_state(rng));
+    }
+
+    auto plan_errors = check_plan_gradient(states);
+    auto state_errors = check_state_gradient(states);
+    std::cout << samples << " random states" << std::endl;
+    std::cout << std::scientific << std::setprecision(2)
+              << "derivatives of the cost w.r.t. the targets vs finite "
+              << "differences: p50 " << percentile(plan_errors, 0.5)
+              << ", p90 " << percentile(plan_errors, 0.9) << std::endl
+              << "derivatives of the puck w.r.t. the initial state vs finite "
+              << "differences: p50 " << percentile(state_errors, 0.5)
+              << ", p90 " << percentile(state_errors, 0.9) << std::endl
+              << std::defaultfloat;
+
+    std::cout << std::setw(10) << "planner"
+              << std::setw(8) << "budget"
+              << std::setw(12) << "ms/plan"
+              << std::setw(12) << "mean cost" << std::endl;
+    // the plan both planners start from
+    ash::Gradient_planner initial(0, 0);
+    print("initial", 0, measure(initial, states));
+    for (int iterations : {1, 2, 5, 10, 20, 50}) {
+        ash::Gradient_planner planner(0, iterations);
+        print("gradient", iterations, measure(planner, states));
+    }
+    for (int budget : {10, 30, 100, 300, 1000, 3000}) {
+        ash::Sampling_planner planner(0, budget);
+        print("sampling", budget, measure(planner, states));
+    }
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include "benchmark_support.hpp"
+#include "physics.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+
+namespace {
+
+template<class To, class From>
+typename To::State convert(const From& state) {
+    typename To::State out;
+    for (size_t i = 0; i < 2; ++i) {
+        out.mallets[i].position = typename To::Vector_2d(
+                state.mallets[i].position);
+        out.mallets[i].velocity = typename To::Vector_2d(
+                state.mallets[i].velocity);
+    }
+    out.puck.position = typename To::Vector_2d(state.puck.position);
+    out.puck.velocity = typename To::Vector_2d(state.puck.velocity);
+    return out;
+}
+
+double distance(const ash::Environment::State& a,
+        const ash::Environment::State& b) {
+    double out = (a.puck.position - b.puck.position).norm();
+    for (size_t i = 0; i < 2; ++i) {
+        out = std::max(out,
+                (a.mallets[i].position - b.mallets[i].position).norm());
+    }
+    return out;
+}
+
+double quantile(std::vector<double> values, double q) {
+    auto k = values.begin() + static_cast<size_t>(q*(values.size() - 1));
+    std::nth_element(values.begin(), k, values.end());
+    return *k;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t ticks = argc > 1? std::stoul(argv[1]) : 200000;
+    size_t runs = argc > 2? std::stoul(argv[2]) : 200;
+
+    auto schedule = ash::benchmark::make_schedule(ticks);
+    double double_rate = ash::benchmark::steps_per_second(
+            ash::Environment(), schedule);
+    double float_rate = ash::benchmark::steps_per_second(
+            ash::Float_environment(), schedule);
+    std::cout << std::fixed << std::setprecision(0)
+              << "double: " << double_rate << " step/s, "
+              << sizeof(ash::Environment::State) << " bytes of state"
+              << std::endl
+              << "float:  " << float_rate << " step/s, "
+              << sizeof(ash::Float_environment::State) << " bytes of state"
+              << std::endl
+              << "speedup: " << std::setprecision(2)
+              << float_rate/double_rate << std::endl << std::endl;
+
+    // Both precisions start from the same (float representable) state and
+    // play the same actions. Matches are chaotic, so after a while they
+    // part ways whatever the precision: the drift report shows how soon.
+    const size_t horizons[] = {1, 10, 50, 100, 250, 500};
+    constexpr size_t longest = 500;
+    std::vector<std::vector<double>> drift(std::size(horizons));
+    for (size_t run = 0; run < runs; ++run) {
+        auto actions = ash::benchmark::make_schedule(longest, run + 2);
+        ash::Environment reference;
+        ash::Float_environment single;
+        reference.reset(run%2);
+        single.set_state(convert<ash::Float_environment>(
+                    reference.get_state()));
+        size_t next = 0;
+        for (size_t t = 1; t <= longest; ++t) {
+            const auto& a = actions[t - 1];
+            int winner = reference.step(a[0], a[1]);
+            int single_winner = single.step(ash::Vector_2f(a[0]),
+                    ash::Vector_2f(a[1]));
+            if (t == horizons[next]) {
+                drift[next].push_back(distance(reference.get_state(),
+                            convert<ash::Environment>(single.get_state())));
+                ++next;
+            }
+            // once the puck is in a goal the match is over
+            if (winner != -1 || single_winner != -1) {
+                break;
+            }
+        }
+    }
+    std::cout << "drift of float from double, " << runs << " matches"
+              << std::endl
+              << std::setw(8) << "ticks"
+              << std::setw(10) << "matches"
+              << std::setw(14) << "median (mm)"
+              << std::setw(14) << "p90 (mm)"
+              << std::setw(14) << "max (mm)" << std::endl;
+    for (size_t i = 0; i < std::size(horizons); ++i) {
+        if (drift[i].empty()) {
+            continue;
+        }
+        std::cout << std::setw(8) << horizons[i]
+                  << std::setw(10) << drift[i].size()
+                  << std::setprecision(4)
+                  << std::setw(14) << quantile(drift[i], 0.5)*1e3
+                  << std::setw(14) << quantile(drift[i], 0.9)*1e3
+                  << std::setw(14) << quantile(drift[i], 1.0)*1e3
+                  << std::endl;
+    }
+}
@@ -0,0 +1,188 @@
+#include "benchmark_support.hpp"
+#include "puck_predictor.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef ash::benchmark::Clock Clock;
+typedef ash::Environment::State State;
+using ash::benchmark::percentile;
+
+constexpr size_t horizon_ticks = 100;
+constexpr size_t checkpoints[] = {5, 25, 50, 100};
+// a guard line in front of the left goal
+constexpr double line_x = -0.6;
+
+// Random puck anywhere on the table, with a speed of up to 6 m/s. The
+// mallets are parked off the table, where nothing can touch them.
+State random_state(std::mt19937& rng) {
+    using namespace ::ash::parameters;
+    std::uniform_real_distribution<double> x(-field_length/2 + puck_radius,
+            field_length/2 - puck_radius);
+    std::uniform_real_distribution<double> y(-field_width/2 + puck_radius,
+            field_width/2 - puck_radius);
+    std::uniform_real_distribution<double> speed(0, 6);
+    std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+    State state;
+    for (size_t i = 0; i < 2; ++i) {
+        state.mallets[i].position = ash::Vector_2d(i == 0? -0.5 : 0.5, 10);
+        state.mallets[i].velocity = ash::Vector_2d(0, 0);
+    }
+    state.puck.position = ash::Vector_2d(x(rng), y(rng));
+    double a = angle(rng);
+    state.puck.velocity = speed(rng)*ash::Vector_2d(std::cos(a), std::sin(a));
+    return state;
+}
+
+struct Outcome {
+    std::array<ash::Vector_2d,std::size(checkpoints)> positions;
+    // ticks played, up to the goal if there is one
+    size_t ticks;
+    int winner;
+    // first tick at the end of which the puck is beyond line_x, or -1
+    int line_tick;
+};
+
+Outcome simulate(const State& state) {
+    ash::Environment env;
+    env.set_state(state);
+    Outcome outcome;
+    outcome.winner = -1;
+    outcome.line_tick = -1;
+    bool left_side = state.puck.position.x <= line_x;
+    size_t next = 0;
+    for (size_t t = 1; t <= horizon_ticks; ++t) {
+        int winner = env.step(state.mallets[0].position,
+                state.mallets[1].position);
+        const auto& puck = env.get_puck().get_position();
+        if (outcome.line_tick == -1 && (puck.x <= line_x) != left_side) {
+            outcome.line_tick = t;
+        }
+        if (t == checkpoints[next]) {
+            outcome.positions[next++] = puck;
+        }
+        outcome.ticks = t;
+        if (winner != -1) {
+            outcome.winner = winner;
+            break;
+        }
+    }
+    return outcome;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    using ash::parameters::dt;
+    size_t samples = argc > 1? std::stoul(argv[1]) : 20000;
+    std::mt19937 rng(1);
+    std::vector<State> states;
+    for (size_t i = 0; i < samples; ++i) {
+        states.push_back(random_state(rng));
+    }
+    ash::Puck_predictor predictor;
+    const double horizon = horizon_ticks*dt;
+
+    // accuracy, split between paths with and without bounces
+    std::array<std::vector<double>,std::size(checkpoints)> errors[2];
+    size_t goals = 0, goals_agreed = 0, goals_missed = 0, false_goals = 0;
+    std::vector<double> line_errors;
+    size_t line_missed = 0;
+    for (const auto& state : states) {
+        auto path = predictor.predict(state, horizon);
+        auto outcome = simulate(state);
+        for (size_t k = 0; k < std::size(checkpoints); ++k) {
+            // the path ends on the goal line
+            if (checkpoints[k] > outcome.ticks || (outcome.winner != -1 &&
+                        checkpoints[k] == outcome.ticks)) {
+                break;
+            }
+            double t = checkpoints[k]*dt;
+            bool bounced = path.get_bounces() > 0 &&
+                path.get_segment(1).start_time <= t;
+            double error = (path.get_position(t) - outcome.positions[k]).norm();
+            errors[bounced][k].push_back(error);
+        }
+        if (outcome.winner != -1) {
+            ++goals;
+            // step notices the goal at the end of the tick
+            auto tick = static_cast<long>(std::ceil(path.get_goal_time()/dt));
+            if (path.get_winner() == outcome.winner &&
+                    std::abs(tick - static_cast<long>(outcome.ticks)) <= 1) {
+                ++goals_agreed;
+            }
+            else if (path.get_winner() == -1) {
+                ++goals_missed;
+            }
+        }
+        else if (path.get_winner() != -1) {
+            ++false_goals;
+        }
+        if (outcome.line_tick != -1) {
+            auto line_time = path.get_time_to_line(line_x);
+            if (!line_time) {
+                ++line_missed;
+            }
+            else {
+                // the tick in which the line is crossed
+                line_errors.push_back(std::abs(*line_time -
+                            (outcome.line_tick - 0.5)*dt));
+            }
+        }
+    }
+
+    std::cout << samples << " random pucks, " << horizon << " s ahead"
+              << std::endl;
+    std::cout << std::setw(10) << "after"
+              << std::setw(16) << "straight p50"
+              << std::setw(14) << "straight max"
+              << std::setw(16) << "bounced p50"
+              << std::setw(14) << "bounced p95" << std::endl;
+    std::cout << std::scientific << std::setprecision(2);
+    for (size_t k = 0; k < std::size(checkpoints); ++k) {
+        std::cout << std::setw(8) << std::defaultfloat << checkpoints[k]*dt
+                  << " s" << std::scientific
+                  << std::setw(16) << percentile(errors[0][k], 0.5)
+                  << std::setw(14) << percentile(errors[0][k], 1)
+                  << std::setw(16) << percentile(errors[1][k], 0.5)
+                  << std::setw(14) << percentile(errors[1][k], 0.95)
+                  << std::endl;
+    }
+    std::cout << std::defaultfloat << "goals: " << goals
+              << ", predicted within a tick: " << goals_agreed
+              << ", missed: " << goals_missed
+              << ", predicted but not scored: " << false_goals << std::endl;
+    std::cout << "time to x = " << line_x << ": median error "
+              << percentile(line_errors, 0.5)*1e3 << " ms, p95 "
+              << percentile(line_errors, 0.95)*1e3 << " ms, missed "
+              << line_missed << std::endl;
+
+    // cost of a prediction against stepping through the horizon
+    auto start = Clock::now();
+    double sum = 0;
+    for (const auto& state : states) {
+        sum += predictor.predict(state, horizon).get_position(horizon).x;
+    }
+    std::chrono::duration<double> predict_time = Clock::now() - start;
+    start = Clock::now();
+    for (const auto& state : states) {
+        sum += simulate(state).positions[0].x;
+    }
+    std::chrono::duration<double> step_time = Clock::now() - start;
+    if (sum == 12345) {
+        std::cout << std::endl;
+    }
+    std::cout << "predict: " << predict_time.count()/samples*1e6
+              << " us, stepping " << horizon_ticks << " ticks: "
+              << step_time.count()/samples*1e6 << " us" << std::endl;
+    return 0;
+}
@@ -0,0 +1,195 @@
+#include "puck_predictor.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+
+double ash::Puck_path::travelled(const Segment& segment, double tau) const {
+    // after k substeps of length h, v = s - k*a*h and the puck has covered
+    // h*(v_1 + ... + v_k) = s*t - a*t*(t + h)/2, with t = k*h
+    double a = deceleration;
+    double h = substep;
+    return segment.speed*tau - a*tau*(tau + h)/2;
+}
+
+double ash::Puck_path::time_to_travel(const Segment& segment,
+        double distance) const {
+    // smaller root of a/2*t^2 - (s - a*h/2)*t + distance = 0, in a form that
+    // holds for a = 0 too
+    double a = deceleration;
+    double b = segment.speed - a*substep/2;
+    double discriminant = std::max(b*b - 2*a*distance, 0.0);
+    return 2*distance/(b + std::sqrt(discriminant));
+}
+
+const ash::Puck_path::Segment& ash::Puck_path::find_segment(double t) const {
+    size_t i = 0;
+    while (i + 1 < segment_count && segments[i + 1].start_time <= t) {
+        ++i;
+    }
+    return segments[i];
+}
+
+ash::Vector_2d ash::Puck_path::get_position(double t) const {
+    const auto& segment = find_segment(t);
+    double tau = std::min(t, segment.end_time) - segment.start_time;
+    return segment.start + travelled(segment, tau)*segment.direction;
+}
+
+ash::Vector_2d ash::Puck_path::get_velocity(double t) const {
+    const auto& segment = find_segment(t);
+    if (t >= stop_time) {
+        return Vector_2d(0, 0);
+    }
+    double tau = std::min(t, segment.end_time) - segment.start_time;
+    return std::max(segment.speed - deceleration*tau, 0.0)*segment.direction;
+}
+
+std::optional<double> ash::Puck_path::get_time_to_line(double x) const {
+    for (size_t i = 0; i < segment_count; ++i) {
+        const auto& segment = segments[i];
+        double length = travelled(segment,
+                segment.end_time - segment.start_time);
+        double dx = segment.direction.x*length;
+        double u = x - segment.start.x;
+        // the line is between the ends of the segment
+        if (dx != 0 && 0 <= u/dx && u/dx <= 1) {
+            return segment.start_time +
+                time_to_travel(segment, u/segment.direction.x);
+        }
+    }
+    return {};
+}
+
+ash::Puck_predictor::Puck_predictor(const Parameter_set& parameters) :
+    parameters(parameters), rink(Runtime_environment(parameters).get_rink())
+{
+}
+
+ash::Puck_path ash::Puck_predictor::predict(const Environment::State& state,
+        double horizon) const {
+    const auto& config = parameters;
+    const double h = config.substep_dt();
+    const double goal_line = config.field_length/2 + config.puck_radius;
+    Puck_path path;
+    path.deceleration = config.gravity*config.puck_mu;
+    path.substep = h;
+    path.segment_count = 0;
+    path.winner = -1;
+    path.goal_time = inf;
+    path.stop_time = inf;
+    const double a = path.deceleration;
+
+    // Time is counted in substeps, and the path is only ever split at the
+    // end of one: along a segment the closed form gives what step would
+    // compute substep by substep, and where a segment ends because of a
+    // wall the puck is handled by the collision code of step.
+    Disk puck(config.puck_radius, config.puck_mass);
+    puck.set_position(state.puck.position);
+    puck.set_velocity(state.puck.velocity);
+    auto overlaps = [this](Disk& puck) {
+        for (auto wall : rink.walls) {
+            if (broadphase_test(wall, puck) && collides(wall, puck)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    long substeps = static_cast<long>(std::ceil(horizon/h - 1e-9));
+    long k = 0;
+    while (path.segment_count < Puck_path::max_segments) {
+        auto& segment = path.segments[path.segment_count++];
+        auto position = puck.get_position();
+        double speed = puck.get_velocity().norm();
+        segment.start_time = k*h;
+        segment.start = position;
+        segment.direction = speed > 0? puck.get_velocity()/speed :
+            Vector_2d(1, 0);
+        segment.speed = speed;
+        segment.end_time = segment.start_time;
+        // the contact with a goal post can push the puck past the line
+        if (std::abs(position.x) > goal_line) {
+            path.winner = position.x > 0? 0 : 1;
+            path.goal_time = segment.start_time;
+            break;
+        }
+        // substeps after which the puck is still moving; in the next one
+        // friction takes what is left of its velocity
+        double moving = a > 0? std::floor(speed/(a*h)) : inf;
+        long n_max = static_cast<long>(std::min<double>(moving,
+                    substeps - k));
+        if (n_max <= 0) {
+            if (moving == 0) {
+                path.stop_time = segment.start_time;
+            }
+            break;
+        }
+        auto direction = segment.direction;
+        auto position_after = [&](long n) {
+            return position + path.travelled(segment, n*h)*direction;
+        };
+
+        // first substep at the end of which the puck overlaps a wall: the
+        // very next one if it is still in contact with a wall it has just
+        // bounced off, otherwise the one that gets it to a wall
+        long n_contact = 0;
+        double length = path.travelled(segment, n_max*h);
+        puck.set_position(position_after(1));
+        if (overlaps(puck)) {
+            n_contact = 1;
+        }
+        else {
+            double first = inf;
+            for (const auto& wall : rink.walls) {
+                auto impact = sweep_disk(position, config.puck_radius,
+                        length*direction, wall.get_bounding_box());
+                if (impact) {
+                    first = std::min(first, impact->time);
+                }
+            }
+            if (first < inf) {
+                double tau = path.time_to_travel(segment, first*length);
+                n_contact = std::min(static_cast<long>(tau/h) + 1, n_max);
+            }
+        }
+        long n = n_contact > 0? n_contact : n_max;
+
+        // a goal is scored once the puck is past the line, which it can only
+        // reach through the mouth of a goal
+        if (direction.x != 0) {
+            double line = direction.x > 0? goal_line : -goal_line;
+            double distance = (line - position.x)/direction.x;
+            if (0 <= distance && distance <= path.travelled(segment, n*h)) {
+                segment.end_time = segment.start_time +
+                    path.time_to_travel(segment, distance);
+                path.winner = direction.x > 0? 0 : 1;
+                path.goal_time = segment.end_time;
+                break;
+            }
+        }
+
+        k += n;
+        segment.end_time = k*h;
+        puck.set_position(position_after(n));
+        puck.set_velocity((speed - n*a*h)*direction);
+        if (n_contact == 0) {
+            if (n == moving) {
+                path.stop_time = segment.end_time;
+            }
+            break;
+        }
+        // what collide_puck_with_rink does, wall after wall
+        for (auto wall : rink.walls) {
+            if (!broadphase_test(wall, puck)) {
+                continue;
+            }
+            if (auto collision = collides(wall, puck)) {
+                resolve_collision(*collision,
+                        config.puck_wall_restitution);
+                correct_position(*collision, config.slop,
+                        config.positional_correction);
+            }
+        }
+    }
+    return path;
+}
@@ -0,0 +1,614 @@
+#include "physics.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+
+// Replays recorded matches through Environment::step and compares them with
+// golden trajectories, to tell whether a change to the physics changed what
+// it computes, and how fast.
+//
+//   regression_suite [check]   compare with the golden trajectories and
+//                              with the baseline timings, if any
+//   regression_suite bless     write the golden trajectories
+//   regression_suite baseline  write the baseline timings
+//   regression_suite record    record the matches again (then bless)
+//
+// Options: --dir D (trajectories), --tolerance X (m and m/s, 1e-9),
+// --slowdown F (fraction of the baseline rate, 0.25) and --no-timing.
+//
+// The matches (D/*.actions) and their golden trajectories (D/*.golden) are
+// part of the tree. The timings depend on the machine, so the baseline
+// (D/baseline.txt) is not: make regression_baseline writes it.
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef ash::Environment::State State;
+typedef ash::Environment::Action Action;
+
+// Targets are recorded in units of 2^-16 m, so that they are exact in text.
+constexpr double unit = 1.0/65536;
+
+// a state is kept every checkpoint_interval ticks, and on every goal
+constexpr size_t checkpoint_interval = 25;
+
+struct Scenario {
+    std::string name;
+    size_t sender;
+    // puck position and velocity after the first reset
+    bool puck_given;
+    State::BodyStatus puck;
+    // names of Environment settings, see configure
+    std::vector<std::string> options;
+    std::vector<std::array<Action,2>> actions;
+};
+
+struct Checkpoint {
+    size_t tick;
+    int winner;
+    State state;
+};
+
+struct Timing {
+    double steps_per_second;
+    double ns_per_substep;
+};
+
+bool configure(ash::Environment& env, const std::string& option) {
+    typedef ash::Environment E;
+    if (option == "adaptive") {
+        env.set_substepping(E::Substepping::adaptive);
+    }
+    else if (option == "velocity_verlet") {
+        env.set_integrator(E::Integrator::velocity_verlet);
+    }
+    else if (option == "runge_kutta") {
+        env.set_integrator(E::Integrator::runge_kutta);
+    }
+    else if (option == "swept") {
+        env.set_collision_detection(E::Collision_detection::swept);
+    }
+    else if (option == "field") {
+        env.set_static_collision(E::Static_collision::field);
+    }
+    else if (option == "packed") {
+        env.set_static_collision(E::Static_collision::packed);
+    }
+    else if (option == "no_fast_path") {
+        env.set_fast_path(false);
+    }
+    else if (option == "no_contact_cache") {
+        env.set_contact_cache(false);
+    }
+    else if (option == "sleeping") {
+        env.set_sleeping(true);
+    }
+    else {
+        return false;
+    }
+    return true;
+}
+
+// Plays the scenario from the start. After a goal the table is reset with
+// the puck on the side of the player who conceded.
+std::vector<Checkpoint> replay(const Scenario& scenario, size_t* substeps) {
+    ash::Environment env;
+    for (const auto& option : scenario.options) {
+        configure(env, option);
+    }
+    size_t sender = scenario.sender;
+    env.reset(sender);
+    if (scenario.puck_given) {
+        auto state = env.get_state();
+        state.puck = scenario.puck;
+        env.set_state(state);
+    }
+    std::vector<Checkpoint> out;
+    if (substeps) {
+        *substeps = 0;
+    }
+    for (size_t t = 0; t < scenario.actions.size(); ++t) {
+        const auto& actions = scenario.actions[t];
+        int winner = env.step(actions[0], actions[1]);
+        if (substeps) {
+            *substeps += env.get_last_substeps();
+        }
+        if (winner != -1 || (t + 1) % checkpoint_interval == 0 ||
+                t + 1 == scenario.actions.size()) {
+            out.push_back({t + 1, winner, env.get_state()});
+        }
+        if (winner != -1) {
+            sender = 1 - winner;
+            env.reset(sender);
+        }
+    }
+    return out;
+}
+
+// best of a few replays
+Timing measure(const Scenario& scenario) {
+    constexpr int repeats = 5;
+    double best = 1e300;
+    size_t substeps = 0;
+    for (int run = 0; run < repeats; ++run) {
+        auto start = Clock::now();
+        replay(scenario, &substeps);
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return {scenario.actions.size()/best,
+        substeps == 0? 0 : best/substeps*1e9};
+}
+
+// Recording
+
+// Mallets pick a random spot in their own half and hold it for a while, or
+// go after the puck. Targets are drawn with integer arithmetic, in units.
+class Recording_player {
+    public:
+        Recording_player(size_t side, std::uint64_t seed, double chase,
+                int min_hold, int max_hold) :
+            side(side), rng(seed), chase(chase), min_hold(min_hold),
+            max_hold(max_hold), target(0, 0), hold(0) {
+        }
+
+        Action get_action(const State& state) {
+            using namespace ::ash::parameters;
+            if (hold > 0) {
+                --hold;
+                return target;
+            }
+            auto draw = [this](double lo, double hi) {
+                auto steps = static_cast<std::uint64_t>((hi - lo)/unit);
+                return lo + static_cast<double>(rng()%steps)*unit;
+            };
+            double sign = side == 0? -1 : 1;
+            if (static_cast<double>(rng()%1000) < 1000*chase) {
+                target = Action(std::round(state.puck.position.x/unit)*unit,
+                        std::round(state.puck.position.y/unit)*unit);
+            }
+            else {
+                target = Action(sign*draw(0.1, field_length/2),
+                        draw(-field_width/2, field_width/2));
+            }
+            hold = min_hold + rng()%(max_hold - min_hold + 1);
+            return target;
+        }
+
+    private:
+        size_t side;
+        std::mt19937_64 rng;
+        double chase;
+        int min_hold;
+        int max_hold;
+        Action target;
+        int hold;
+};
+
+struct Recipe {
+    const char* name;
+    std::uint64_t seed;
+    size_t ticks;
+    // chance of going after the puck, and ticks a target is held
+    double chase;
+    int min_hold;
+    int max_hold;
+    // puck position and velocity after the first reset, if any
+    std::array<double,4> puck;
+    std::vector<std::string> options;
+};
+
+const std::vector<Recipe>& get_recipes() {
+    static const std::vector<Recipe> recipes = {
+        {"rally", 1, 3000, 0.3, 5, 50, {}, {}},
+        {"scramble", 2, 3000, 0.9, 1, 8, {}, {}},
+        {"bank_shots", 3, 1500, 0, 100, 200, {0.2, 0.05, -3.5, 2.75}, {}},
+        {"rally_adaptive", 4, 2000, 0.5, 3, 30, {}, {"adaptive"}},
+        {"rally_swept", 5, 2000, 0.5, 3, 30, {}, {"swept"}},
+        {"rally_verlet", 6, 2000, 0.5, 3, 30, {}, {"velocity_verlet"}},
+        {"rally_runge_kutta", 7, 2000, 0.5, 3, 30, {}, {"runge_kutta"}},
+        {"rally_field", 8, 2000, 0.5, 3, 30, {}, {"field"}},
+        {"rally_packed", 9, 2000, 0.5, 3, 30, {}, {"packed"}},
+        {"idle_sleeping", 10, 1500, 0, 200, 400, {0, 0.1, 1.5, -0.5},
+            {"sleeping"}},
+    };
+    return recipes;
+}
+
+// Plays the recipe with its recording players and keeps their actions.
+Scenario record(const Recipe& recipe) {
+    Scenario scenario;
+    scenario.name = recipe.name;
+    scenario.sender = 0;
+    scenario.puck_given = recipe.puck != std::array<double,4>{};
+    scenario.puck.position = Action(recipe.puck[0], recipe.puck[1]);
+    scenario.puck.velocity = Action(recipe.puck[2], recipe.puck[3]);
+    scenario.options = recipe.options;
+
+    Recording_player players[] = {
+        Recording_player(0, 2*recipe.seed, recipe.chase, recipe.min_hold,
+                recipe.max_hold),
+        Recording_player(1, 2*recipe.seed + 1, recipe.chase,
+                recipe.min_hold, recipe.max_hold)};
+    ash::Environment env;
+    for (const auto& option : scenario.options) {
+        configure(env, option);
+    }
+    env.reset(scenario.sender);
+    if (scenario.puck_given) {
+        auto state = env.get_state();
+        state.puck = scenario.puck;
+        env.set_state(state);
+    }
+    for (size_t t = 0; t < recipe.ticks; ++t) {
+        auto state = env.get_state();
+        std::array<Action,2> actions = {players[0].get_action(state),
+            players[1].get_action(state)};
+        scenario.actions.push_back(actions);
+        int winner = env.step(actions[0], actions[1]);
+        if (winner != -1) {
+            env.reset(1 - winner);
+        }
+    }
+    return scenario;
+}
+
+// Files
+
+// Header lines ("sender s", "puck x y vx vy", "option name"), then one line
+// per run of ticks with the same targets: "count x1 y1 x2 y2" in units.
+void write_actions(const Scenario& scenario, std::ostream& out) {
+    out << std::setprecision(17);
+    out << "sender " << scenario.sender << '\n';
+    if (scenario.puck_given) {
+        const auto& puck = scenario.puck;
+        out << "puck " << puck.position.x << ' ' << puck.position.y << ' '
+            << puck.velocity.x << ' ' << puck.velocity.y << '\n';
+    }
+    for (const auto& option : scenario.options) {
+        out << "option " << option << '\n';
+    }
+    auto to_units = [](double x) {
+        return static_cast<long long>(std::round(x/unit));
+    };
+    for (size_t t = 0; t < scenario.actions.size();) {
+        size_t run = 1;
+        while (t + run < scenario.actions.size() &&
+                scenario.actions[t + run] == scenario.actions[t]) {
+            ++run;
+        }
+        const auto& actions = scenario.actions[t];
+        out << run << ' ' << to_units(actions[0].x) << ' '
+            << to_units(actions[0].y) << ' ' << to_units(actions[1].x) << ' '
+            << to_units(actions[1].y) << '\n';
+        t += run;
+    }
+}
+
+bool read_actions(std::istream& in, Scenario& scenario) {
+    scenario.sender = 0;
+    scenario.puck_given = false;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first)) {
+            continue;
+        }
+        if (first == "sender") {
+            fields >> scenario.sender;
+        }
+        else if (first == "puck") {
+            auto& puck = scenario.puck;
+            fields >> puck.position.x >> puck.position.y >> puck.velocity.x
+                >> puck.velocity.y;
+            scenario.puck_given = true;
+        }
+        else if (first == "option") {
+            std::string option;
+            fields >> option;
+            ash::Environment env;
+            if (!configure(env, option)) {
+                std::cerr << "unknown option " << option << std::endl;
+                return false;
+            }
+            scenario.options.push_back(option);
+        }
+        else {
+            size_t run = std::stoul(first);
+            long long units[4];
+            fields >> units[0] >> units[1] >> units[2] >> units[3];
+            std::array<Action,2> actions = {
+                Action(units[0]*unit, units[1]*unit),
+                Action(units[2]*unit, units[3]*unit)};
+            scenario.actions.insert(scenario.actions.end(), run, actions);
+        }
+        if (!fields) {
+            std::cerr << "bad line: " << line << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// One line per checkpoint: tick, winner, then position and velocity of
+// both mallets and the puck, with every digit needed to read them back.
+void write_golden(const std::vector<Checkpoint>& checkpoints,
+        std::ostream& out) {
+    out << std::setprecision(17);
+    for (const auto& checkpoint : checkpoints) {
+        out << checkpoint.tick << ' ' << checkpoint.winner;
+        const auto& s = checkpoint.state;
+        for (const auto* body : {&s.mallets[0], &s.mallets[1], &s.puck}) {
+            out << ' ' << body->position.x << ' ' << body->position.y
+                << ' ' << body->velocity.x << ' ' << body->velocity.y;
+        }
+        out << '\n';
+    }
+}
+
+bool read_golden(std::istream& in, std::vector<Checkpoint>& checkpoints) {
+    Checkpoint checkpoint;
+    while (in >> checkpoint.tick >> checkpoint.winner) {
+        auto& s = checkpoint.state;
+        for (auto* body : {&s.mallets[0], &s.mallets[1], &s.puck}) {
+            in >> body->position.x >> body->position.y >> body->velocity.x
+                >> body->velocity.y;
+        }
+        checkpoints.push_back(checkpoint);
+    }
+    return in.eof();
+}
+
+// "name steps_per_second ns_per_substep" per line
+std::map<std::string, Timing> read_baseline(const std::string& path) {
+    std::map<std::string, Timing> out;
+    std::ifstream in(path);
+    std::string name;
+    Timing timing;
+    while (in >> name >> timing.steps_per_second >> timing.ns_per_substep) {
+        out[name] = timing;
+    }
+    return out;
+}
+
+std::vector<Scenario> load_scenarios(const std::string& dir) {
+    std::vector<Scenario> out;
+    for (const auto& recipe : get_recipes()) {
+        std::ifstream in(dir + "/" + recipe.name + ".actions");
+        Scenario scenario;
+        scenario.name = recipe.name;
+        if (!in || !read_actions(in, scenario)) {
+            std::cerr << "cannot read " << dir << "/" << recipe.name
+                      << ".actions (make it with record)" << std::endl;
+            continue;
+        }
+        out.push_back(scenario);
+    }
+    return out;
+}
+
+// Checking
+
+struct Comparison {
+    // largest difference in position and in velocity at the checkpoints
+    // before the trajectories part ways
+    double position_error;
+    double velocity_error;
+    // first checkpoint beyond tolerance, or with another winner, if any
+    bool diverged;
+    size_t divergence_tick;
+};
+
+Comparison compare(const std::vector<Checkpoint>& golden,
+        const std::vector<Checkpoint>& actual, double tolerance) {
+    Comparison out = {0, 0, false, 0};
+    if (golden.size() != actual.size()) {
+        // a goal on another tick adds or removes a checkpoint
+        out.diverged = true;
+    }
+    size_t count = std::min(golden.size(), actual.size());
+    for (size_t i = 0; i < count; ++i) {
+        const auto& g = golden[i];
+        const auto& a = actual[i];
+        if (g.tick != a.tick || g.winner != a.winner) {
+            out.diverged = true;
+            out.divergence_tick = std::min(g.tick, a.tick);
+            return out;
+        }
+        double position_error = 0;
+        double velocity_error = 0;
+        const State::BodyStatus* g_bodies[] = {&g.state.mallets[0],
+            &g.state.mallets[1], &g.state.puck};
+        const State::BodyStatus* a_bodies[] = {&a.state.mallets[0],
+            &a.state.mallets[1], &a.state.puck};
+        for (size_t b = 0; b < 3; ++b) {
+            position_error = std::max(position_error,
+                    (g_bodies[b]->position - a_bodies[b]->position).norm());
+            velocity_error = std::max(velocity_error,
+                    (g_bodies[b]->velocity - a_bodies[b]->velocity).norm());
+        }
+        if (!(position_error <= tolerance && velocity_error <= tolerance)) {
+            out.diverged = true;
+            out.divergence_tick = g.tick;
+            return out;
+        }
+        out.position_error = std::max(out.position_error, position_error);
+        out.velocity_error = std::max(out.velocity_error, velocity_error);
+    }
+    if (out.diverged) {
+        out.divergence_tick = count > 0? golden[count - 1].tick : 0;
+    }
+    return out;
+}
+
+struct Options {
+    std::string command = "check";
+    std::string dir = "trajectories";
+    double tolerance = 1e-9;
+    double slowdown = 0.25;
+    bool timing = true;
+};
+
+int check(const Options& options) {
+    auto scenarios = load_scenarios(options.dir);
+    auto baseline = read_baseline(options.dir + "/baseline.txt");
+    bool failed = scenarios.size() != get_recipes().size();
+    if (baseline.empty() && options.timing) {
+        std::cout << "no baseline timings in " << options.dir
+                  << " (make regression_baseline)" << std::endl;
+    }
+    std::cout << std::left << std::setw(20) << "scenario" << std::right
+              << std::setw(7) << "ticks"
+              << std::setw(11) << "pos err"
+              << std::setw(11) << "vel err"
+              << std::setw(11) << "steps/s"
+              << std::setw(10) << "ns/sub"
+              << std::setw(9) << "vs base"
+              << "  status" << std::endl;
+    for (const auto& scenario : scenarios) {
+        std::vector<Checkpoint> golden;
+        std::ifstream in(options.dir + "/" + scenario.name + ".golden");
+        bool have_golden = in && read_golden(in, golden);
+        auto comparison = compare(golden, replay(scenario, nullptr),
+                options.tolerance);
+
+        std::cout << std::left << std::setw(20) << scenario.name
+                  << std::right << std::setw(7) << scenario.actions.size()
+                  << std::scientific << std::setprecision(1)
+                  << std::setw(11) << comparison.position_error
+                  << std::setw(11) << comparison.velocity_error
+                  << std::fixed << std::setprecision(0);
+        std::string status;
+        if (!have_golden) {
+            status = "no golden trajectory";
+            failed = true;
+        }
+        else if (comparison.diverged) {
+            status = "DIVERGED at tick " +
+                std::to_string(comparison.divergence_tick);
+            failed = true;
+        }
+        else {
+            status = "ok";
+        }
+        if (options.timing) {
+            auto timing = measure(scenario);
+            std::cout << std::setw(11) << timing.steps_per_second
+                      << std::setprecision(1)
+                      << std::setw(10) << timing.ns_per_substep;
+            auto base = baseline.find(scenario.name);
+            if (base != baseline.end()) {
+                double ratio = timing.steps_per_second/
+                    base->second.steps_per_second;
+                std::cout << std::setprecision(2) << std::setw(9) << ratio;
+                if (ratio < 1 - options.slowdown) {
+                    status += ", SLOW";
+                    failed = true;
+                }
+            }
+            else {
+                std::cout << std::setw(9) << "-";
+            }
+        }
+        else {
+            std::cout << std::setw(11) << "-" << std::setw(10) << "-"
+                      << std::setw(9) << "-";
+        }
+        std::cout << std::defaultfloat << "  " << status << std::endl;
+    }
+    std::cout << (failed? "FAILED" : "passed") << std::endl;
+    return failed? 1 : 0;
+}
+
+int write_files(const Options& options) {
+    if (options.command == "record") {
+        for (const auto& recipe : get_recipes()) {
+            std::ofstream out(options.dir + "/" + recipe.name + ".actions");
+            write_actions(record(recipe), out);
+            if (!out) {
+                std::cerr << "cannot write " << recipe.name << std::endl;
+                return 1;
+            }
+        }
+        std::cout << "recorded " << get_recipes().size() << " scenarios in "
+                  << options.dir << std::endl;
+        return 0;
+    }
+    auto scenarios = load_scenarios(options.dir);
+    if (scenarios.size() != get_recipes().size()) {
+        return 1;
+    }
+    if (options.command == "bless") {
+        for (const auto& scenario : scenarios) {
+            std::ofstream out(options.dir + "/" + scenario.name + ".golden");
+            write_golden(replay(scenario, nullptr), out);
+            if (!out) {
+                std::cerr << "cannot write " << scenario.name << std::endl;
+                return 1;
+            }
+        }
+        std::cout << "wrote the golden trajectories of " << scenarios.size()
+                  << " scenarios" << std::endl;
+        return 0;
+    }
+    std::ofstream out(options.dir + "/baseline.txt");
+    out << std::setprecision(6);
+    for (const auto& scenario : scenarios) {
+        auto timing = measure(scenario);
+        out << scenario.name << ' ' << timing.steps_per_second << ' '
+            << timing.ns_per_substep << '\n';
+    }
+    std::cout << "wrote the baseline timings of " << scenarios.size()
+              << " scenarios" << std::endl;
+    return out? 0 : 1;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--dir" && i + 1 < argc) {
+            options.dir = argv[++i];
+        }
+        else if (arg == "--tolerance" && i + 1 < argc) {
+            options.tolerance = std::stod(argv[++i]);
+        }
+        else if (arg == "--slowdown" && i + 1 < argc) {
+            options.slowdown = std::stod(argv[++i]);
+        }
+        else if (arg == "--no-timing") {
+            options.timing = false;
+        }
+        else if (arg == "check" || arg == "bless" || arg == "baseline" ||
+                arg == "record") {
+            options.command = arg;
+        }
+        else {
+            std::cerr << "Usage: " << argv[0]
+                      << " [check|bless|baseline|record] [--dir D]"
+                      << " [--tolerance X] [--slowdown F] [--no-timing]\n";
+            return 2;
+        }
+    }
+    if (options.command == "check") {
+        return check(options);
+    }
+    return write_files(options);
+}
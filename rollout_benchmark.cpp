@@ -0,0 +1,77 @@
+#include "rollout_pool.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+}
+
+
+int main(int argc, char* argv[]) {
+    using namespace ::ash::parameters;
+    size_t tables = argc > 1? std::stoul(argv[1]) : 2048;
+    size_t ticks = argc > 2? std::stoul(argv[2]) : 100;
+    size_t max_workers = std::max(1u, std::thread::hardware_concurrency());
+
+    // random targets around the whole field, regenerated every tick
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> x(-field_length/2, field_length/2);
+    std::uniform_real_distribution<double> y(-field_width/2, field_width/2);
+    std::vector<std::vector<ash::Rollout_pool::Action_pair>> actions(ticks,
+            std::vector<ash::Rollout_pool::Action_pair>(tables));
+    for (auto& tick : actions) {
+        for (auto& pair : tick) {
+            pair[0] = ash::Vector_2d(-std::abs(x(rng)), y(rng));
+            pair[1] = ash::Vector_2d(std::abs(x(rng)), y(rng));
+        }
+    }
+
+    std::cout << tables << " tables, " << ticks << " ticks" << std::endl;
+    std::cout << std::setw(8) << "workers"
+              << std::setw(14) << "steps/s"
+              << std::setw(10) << "speedup"
+              << std::setw(10) << "min util"
+              << std::setw(10) << "max util"
+              << std::setw(10) << "steals" << std::endl;
+    // powers of two and the number of hardware threads
+    std::vector<size_t> worker_counts;
+    for (size_t workers = 1; workers < max_workers; workers *= 2) {
+        worker_counts.push_back(workers);
+    }
+    worker_counts.push_back(max_workers);
+
+    double base_rate = 0;
+    for (size_t workers : worker_counts) {
+        ash::Rollout_pool pool(tables, workers);
+        auto start = Clock::now();
+        for (const auto& tick : actions) {
+            pool.step(tick);
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        double rate = ticks*tables/elapsed.count();
+        if (workers == 1) {
+            base_rate = rate;
+        }
+        double min_util = 1;
+        double max_util = 0;
+        size_t steals = 0;
+        for (const auto& stats : pool.get_worker_stats()) {
+            min_util = std::min(min_util, stats.utilization);
+            max_util = std::max(max_util, stats.utilization);
+            steals += stats.steals;
+        }
+        std::cout << std::fixed
+                  << std::setw(8) << workers
+                  << std::setw(14) << std::setprecision(0) << rate
+                  << std::setw(10) << std::setprecision(2) << rate/base_rate
+                  << std::setw(10) << min_util
+                  << std::setw(10) << max_util
+                  << std::setw(10) << steals << std::endl;
+    }
+}
@@ -0,0 +1,160 @@
+#include "rollout_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// a few chunks per worker leave room for stealing without paying the
+// atomic increment for every table
+constexpr size_t chunks_per_worker = 8;
+
+}
+
+ash::Rollout_pool::Rollout_pool(size_t tables, size_t worker_count) :
+    environments(tables),
+    senders(tables, 0),
+    results(tables),
+    actions(nullptr),
+    workers(std::max<size_t>(1, worker_count)),
+    wall_seconds(0),
+    generation(0),
+    finished(0),
+    stopping(false)
+{
+    chunk_size = std::max<size_t>(1,
+            tables/(workers.size()*chunks_per_worker));
+    chunk_count = (tables + chunk_size - 1)/chunk_size;
+    reset_worker_stats();
+    for (size_t i = 0; i < workers.size(); ++i) {
+        workers[i].next_chunk = 0;
+        workers[i].end_chunk = 0;
+        workers[i].thread = std::thread(&Rollout_pool::run, this, i);
+    }
+}
+
+ash::Rollout_pool::~Rollout_pool() {
+    {
+        std::unique_lock lck{mtx};
+        stopping = true;
+    }
+    start_cv.notify_all();
+    for (auto& worker : workers) {
+        worker.thread.join();
+    }
+}
+
+const std::vector<ash::Rollout_pool::Result>& ash::Rollout_pool::step(
+        const std::vector<Action_pair>& actions) {
+    auto start = Clock::now();
+    {
+        std::unique_lock lck{mtx};
+        this->actions = &actions;
+        // hand every worker a contiguous range of chunks
+        size_t n = workers.size();
+        for (size_t i = 0; i < n; ++i) {
+            workers[i].next_chunk = i*chunk_count/n;
+            workers[i].end_chunk = (i+1)*chunk_count/n;
+        }
+        finished = 0;
+        ++generation;
+    }
+    start_cv.notify_all();
+    {
+        std::unique_lock lck{mtx};
+        done_cv.wait(lck, [this]{return finished == workers.size();});
+        this->actions = nullptr;
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    wall_seconds += elapsed.count();
+    return results;
+}
+
+std::vector<ash::Rollout_pool::Worker_stats>
+ash::Rollout_pool::get_worker_stats() const {
+    std::vector<Worker_stats> stats(workers.size());
+    for (size_t i = 0; i < workers.size(); ++i) {
+        stats[i].busy_seconds = workers[i].busy_seconds;
+        stats[i].utilization = wall_seconds > 0?
+            workers[i].busy_seconds/wall_seconds : 0;
+        stats[i].chunks = workers[i].chunks;
+        stats[i].steals = workers[i].steals;
+    }
+    return stats;
+}
+
+void ash::Rollout_pool::reset_worker_stats() {
+    wall_seconds = 0;
+    for (auto& worker : workers) {
+        worker.busy_seconds = 0;
+        worker.chunks = 0;
+        worker.steals = 0;
+    }
+}
+
+void ash::Rollout_pool::run(size_t index) {
+    auto& self = workers[index];
+    size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock lck{mtx};
+            start_cv.wait(lck, [&]{return stopping || generation != seen;});
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+        }
+        auto start = Clock::now();
+        // own range first, then steal starting from the next worker
+        while (run_chunk(index)) {
+            ++self.chunks;
+        }
+        for (size_t i = 1; i < workers.size(); ++i) {
+            size_t victim = (index + i) % workers.size();
+            while (run_chunk(victim)) {
+                ++self.chunks;
+                ++self.steals;
+            }
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        self.busy_seconds += elapsed.count();
+        {
+            std::unique_lock lck{mtx};
+            ++finished;
+        }
+        done_cv.notify_one();
+    }
+}
+
+bool ash::Rollout_pool::run_chunk(size_t owner) {
+    auto& queue = workers[owner];
+    // owner and thieves take chunks from the same end of the range, so a
+    // single atomic increment is enough to claim one
+    if (queue.next_chunk.load(std::memory_order_relaxed) >= queue.end_chunk) {
+        return false;
+    }
+    size_t chunk = queue.next_chunk.fetch_add(1, std::memory_order_relaxed);
+    if (chunk >= queue.end_chunk) {
+        return false;
+    }
+    step_chunk(chunk);
+    return true;
+}
+
+void ash::Rollout_pool::step_chunk(size_t chunk) {
+    size_t begin = chunk*chunk_size;
+    size_t end = std::min(environments.size(), begin + chunk_size);
+    for (size_t i = begin; i < end; ++i) {
+        const auto& action = (*actions)[i];
+        int winner = environments[i].step(action[0], action[1]);
+        if (winner != -1) {
+            senders[i] = 1 - senders[i];
+            environments[i].reset(senders[i]);
+        }
+        results[i].state = environments[i].get_state();
+        results[i].winner = winner;
+    }
+}
@@ -0,0 +1,194 @@
+#include "vector_pack.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// vectors per batch: a few of them fit in L1, as the bodies of a batch of
+// tables would
+constexpr size_t batch = 1024;
+
+struct Batch {
+    std::vector<double> x1, y1, x2, y2;
+};
+
+Batch make_batch() {
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> coordinate(-2, 2);
+    Batch out;
+    for (auto* v : {&out.x1, &out.y1, &out.x2, &out.y2}) {
+        v->resize(batch);
+        for (auto& c : *v) {
+            c = coordinate(rng);
+        }
+    }
+    return out;
+}
+
+bool same_bits(const std::vector<double>& a, const std::vector<double>& b) {
+    return std::memcmp(a.data(), b.data(), a.size()*sizeof(double)) == 0;
+}
+
+// nanoseconds per vector of op, best of a few runs
+template<class Op>
+double measure(Op op) {
+    constexpr size_t repeats = 2000;
+    double best = 1e300;
+    for (int run = 0; run < 5; ++run) {
+        auto start = Clock::now();
+        for (size_t r = 0; r < repeats; ++r) {
+            op();
+        }
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        best = std::min(best, elapsed.count()/(repeats*batch)*1e9);
+    }
+    return best;
+}
+
+// what each operation has to match: Vector_2d, one vector at a time
+struct Reference {
+    std::vector<double> norm, normalize_x, normalize_y, dot;
+};
+
+Reference make_reference(const Batch& b) {
+    Reference out;
+    for (size_t i = 0; i < batch; ++i) {
+        ash::Vector_2d u(b.x1[i], b.y1[i]), v(b.x2[i], b.y2[i]);
+        out.norm.push_back(u.norm());
+        auto n = u.normalize();
+        out.normalize_x.push_back(n.x);
+        out.normalize_y.push_back(n.y);
+        out.dot.push_back(u.dot(v));
+    }
+    return out;
+}
+
+void print_row(const char* name, double norm, double normalize, double dot,
+        bool same) {
+    std::cout << std::setw(12) << name
+              << std::fixed << std::setprecision(3)
+              << std::setw(10) << norm
+              << std::setw(12) << normalize
+              << std::setw(10) << dot
+              << std::setw(8) << (same? "yes" : "NO")
+              << std::defaultfloat << std::endl;
+}
+
+// The packs of the build: Lanes vectors per operation.
+template<size_t Lanes>
+bool run_pack(const char* name, const Batch& b, const Reference& reference) {
+    typedef ash::Vector_2d_pack<Lanes> Pack;
+    std::vector<double> norm(batch), nx(batch), ny(batch), dot(batch);
+    auto norms = [&] {
+        for (size_t i = 0; i < batch; i += Lanes) {
+            Pack::load(&b.x1[i], &b.y1[i]).norm().store(&norm[i]);
+        }
+    };
+    auto normalizes = [&] {
+        for (size_t i = 0; i < batch; i += Lanes) {
+            Pack::load(&b.x1[i], &b.y1[i]).normalize().store(&nx[i], &ny[i]);
+        }
+    };
+    auto dots = [&] {
+        for (size_t i = 0; i < batch; i += Lanes) {
+            auto u = Pack::load(&b.x1[i], &b.y1[i]);
+            u.dot(Pack::load(&b.x2[i], &b.y2[i])).store(&dot[i]);
+        }
+    };
+    double t_norm = measure(norms);
+    double t_normalize = measure(normalizes);
+    double t_dot = measure(dots);
+    bool same = same_bits(norm, reference.norm) &&
+        same_bits(nx, reference.normalize_x) &&
+        same_bits(ny, reference.normalize_y) && same_bits(dot, reference.dot);
+    print_row(name, t_norm, t_normalize, t_dot, same);
+    return same;
+}
+
+}
+
+
+int main() {
+    auto b = make_batch();
+    auto reference = make_reference(b);
+    bool all_same = true;
+    std::cout << batch << " vectors per batch, ns per vector" << std::endl;
+    std::cout << std::setw(12) << "kernels"
+              << std::setw(10) << "norm"
+              << std::setw(12) << "normalize"
+              << std::setw(10) << "dot"
+              << std::setw(8) << "same" << std::endl;
+
+    // Vector_2d, as the physics uses it
+    {
+        std::vector<ash::Vector_2d> u(batch), v(batch);
+        for (size_t i = 0; i < batch; ++i) {
+            u[i] = ash::Vector_2d(b.x1[i], b.y1[i]);
+            v[i] = ash::Vector_2d(b.x2[i], b.y2[i]);
+        }
+        std::vector<double> out(batch);
+        std::vector<ash::Vector_2d> normalized(batch);
+        auto norms = [&] {
+            for (size_t i = 0; i < batch; ++i) {
+                out[i] = u[i].norm();
+            }
+        };
+        auto normalizes = [&] {
+            for (size_t i = 0; i < batch; ++i) {
+                normalized[i] = u[i].normalize();
+            }
+        };
+        auto dots = [&] {
+            for (size_t i = 0; i < batch; ++i) {
+                out[i] = u[i].dot(v[i]);
+            }
+        };
+        print_row("Vector_2d", measure(norms), measure(normalizes),
+                measure(dots), true);
+    }
+
+    // batched kernels, picked at run time
+    for (auto isa : {ash::Simd_isa::scalar, ash::Simd_isa::sse2,
+            ash::Simd_isa::avx2, ash::Simd_isa::avx512}) {
+        if (!ash::is_supported(isa)) {
+            std::cout << std::setw(12) << ash::get_name(isa)
+                      << "  not supported here" << std::endl;
+            continue;
+        }
+        const auto& kernels = ash::get_simd_kernels(isa);
+        std::vector<double> norm(batch), nx(batch), ny(batch), dot(batch);
+        double t_norm = measure([&] {
+                kernels.norm(b.x1.data(), b.y1.data(), norm.data(), batch);
+            });
+        double t_normalize = measure([&] {
+                kernels.normalize(b.x1.data(), b.y1.data(), nx.data(),
+                        ny.data(), batch);
+            });
+        double t_dot = measure([&] {
+                kernels.dot(b.x1.data(), b.y1.data(), b.x2.data(),
+                        b.y2.data(), dot.data(), batch);
+            });
+        bool same = same_bits(norm, reference.norm) &&
+            same_bits(nx, reference.normalize_x) &&
+            same_bits(ny, reference.normalize_y) &&
+            same_bits(dot, reference.dot);
+        all_same = all_same && same;
+        print_row(ash::get_name(isa), t_norm, t_normalize, t_dot, same);
+    }
+    std::cout << "default: " << ash::get_name(ash::get_simd_kernels().isa)
+              << std::endl;
+
+    // packs, with the instruction set of the build
+    all_same = run_pack<2>("pack x2", b, reference) && all_same;
+    all_same = run_pack<4>("pack x4", b, reference) && all_same;
+    all_same = run_pack<8>("pack x8", b, reference) && all_same;
+    return all_same? 0 : 1;
+}
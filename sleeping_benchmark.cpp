@@ -0,0 +1,152 @@
+#include "physics.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef ash::Environment::State State;
+typedef ash::Environment::Action Action;
+
+// A bot that guards its goal and only now and then goes for the puck when
+// it is in its own half. After every goal both bots wait for the serve.
+class Lazy_player {
+    public:
+        Lazy_player(size_t side, unsigned seed) :
+            side(side), rng(seed), target(guard()), hold(0) {
+        }
+
+        Action get_action(const State& state) {
+            using namespace ::ash::parameters;
+            if (hold > 0) {
+                --hold;
+                return target;
+            }
+            std::bernoulli_distribution strike(0.3);
+            std::uniform_int_distribution<int> ticks(10, 100);
+            double sign = side == 0? -1 : 1;
+            const auto& puck = state.puck.position;
+            // strike through the puck towards the other goal
+            target = sign*puck.x > 0 && strike(rng)?
+                puck - Action(sign*0.2, 0) : guard();
+            hold = ticks(rng);
+            return target;
+        }
+
+        void wait_for_serve(int ticks) {
+            target = guard();
+            hold = ticks;
+        }
+
+    private:
+        Action guard() const {
+            using namespace ::ash::parameters;
+            double sign = side == 0? -1 : 1;
+            return Action(sign*(field_length/2 - 0.15), 0);
+        }
+
+        size_t side;
+        std::mt19937 rng;
+        Action target;
+        int hold;
+};
+
+double distance(const State& a, const State& b) {
+    double out = (a.puck.position - b.puck.position).norm();
+    for (size_t i = 0; i < 2; ++i) {
+        out = std::max(out,
+                (a.mallets[i].position - b.mallets[i].position).norm());
+    }
+    return out;
+}
+
+struct Report {
+    double rate;
+    size_t asleep_ticks;
+    size_t goals;
+};
+
+Report play(bool sleeping, size_t ticks) {
+    ash::Environment env;
+    env.set_sleeping(sleeping);
+    Lazy_player players[] = {Lazy_player(0, 1), Lazy_player(1, 2)};
+    size_t sender = 0;
+    Report report = {};
+    auto start = Clock::now();
+    for (size_t t = 0; t < ticks; ++t) {
+        auto state = env.get_state();
+        auto a1 = players[0].get_action(state);
+        auto a2 = players[1].get_action(state);
+        if (env.step(a1, a2) != -1) {
+            ++report.goals;
+            sender = 1 - sender;
+            env.reset(sender);
+            players[0].wait_for_serve(150);
+            players[1].wait_for_serve(150);
+        }
+        report.asleep_ticks += env.get_last_substeps() == 0;
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    report.rate = ticks/elapsed.count();
+    return report;
+}
+
+// Plays with sleeping bodies, and steps a copy of the environment with
+// every body awake from the same state at every tick, so that the error
+// reported is the error of a single tick.
+void compare(size_t ticks, double& mean_error, double& max_error) {
+    ash::Environment env;
+    env.set_sleeping(true);
+    Lazy_player players[] = {Lazy_player(0, 1), Lazy_player(1, 2)};
+    size_t sender = 0;
+    mean_error = max_error = 0;
+    for (size_t t = 0; t < ticks; ++t) {
+        auto state = env.get_state();
+        auto a1 = players[0].get_action(state);
+        auto a2 = players[1].get_action(state);
+        auto awake = env;
+        awake.set_sleeping(false);
+        int awake_winner = awake.step(a1, a2);
+        int winner = env.step(a1, a2);
+        if (winner == -1 && awake_winner == -1) {
+            double error = distance(awake.get_state(), env.get_state());
+            mean_error += error;
+            max_error = std::max(max_error, error);
+        }
+        if (winner != -1) {
+            sender = 1 - sender;
+            env.reset(sender);
+            players[0].wait_for_serve(150);
+            players[1].wait_for_serve(150);
+        }
+    }
+    mean_error /= ticks;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t ticks = argc > 1? std::stoul(argv[1]) : 200000;
+    auto awake = play(false, ticks);
+    auto asleep = play(true, ticks);
+    double mean_error, max_error;
+    compare(ticks, mean_error, max_error);
+    std::cout << ticks << " ticks" << std::endl << std::fixed
+              << std::setprecision(0)
+              << "awake:    " << awake.rate << " step/s, "
+              << awake.goals << " goals" << std::endl
+              << "sleeping: " << asleep.rate << " step/s, "
+              << asleep.goals << " goals, " << std::setprecision(1)
+              << 100.0*asleep.asleep_ticks/ticks << "% of the ticks with "
+              << "every body asleep" << std::endl
+              << "speedup:  " << std::setprecision(2)
+              << asleep.rate/awake.rate << std::endl
+              << "error per tick: mean " << std::setprecision(4)
+              << mean_error*1e3 << " mm, max " << max_error*1e3 << " mm"
+              << std::endl;
+}
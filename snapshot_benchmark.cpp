@@ -0,0 +1,245 @@
+#include "benchmark_support.hpp"
+#include "physics.hpp"
+#include "undo_log.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef ash::benchmark::Clock Clock;
+typedef ash::Environment::State State;
+typedef ash::Environment::Action Action;
+typedef std::array<Action,2> Action_pair;
+using ash::benchmark::same_bits;
+
+constexpr size_t branching = 4;
+
+Action random_target(std::mt19937& rng, size_t side) {
+    using namespace ::ash::parameters;
+    std::uniform_real_distribution<double> x(0.1, field_length/2);
+    std::uniform_real_distribution<double> y(-field_width/2, field_width/2);
+    return Action(side == 0? -x(rng) : x(rng), y(rng));
+}
+
+// the actions tried at every node of the search: each mallet goes for the
+// puck from one of four directions
+Action_pair branch(const ash::Environment& env, size_t b) {
+    const auto& puck = env.get_puck().get_position();
+    const Action offsets[branching] = {
+        Action(0.1, 0), Action(0.05, 0.08), Action(0.05, -0.08),
+        Action(0, 0)};
+    return {puck - offsets[b], puck + offsets[b]};
+}
+
+// Takes a detour of a few random ticks from every tick of a game and comes
+// back to where it was, first with set_state and then with a snapshot. A
+// reference environment plays the game without detours. Returns the ticks
+// at which each way of coming back differs from the reference.
+std::array<size_t,2> check_restore(size_t ticks) {
+    std::mt19937 rng(1);
+    ash::Environment reference, by_state, by_snapshot;
+    for (auto* env : {&reference, &by_state, &by_snapshot}) {
+        env->set_sleeping(true);
+    }
+    std::array<size_t,2> mismatches = {};
+    Action_pair targets = {random_target(rng, 0), random_target(rng, 1)};
+    size_t sender = 0;
+    for (size_t t = 0; t < ticks; ++t) {
+        if (t % 37 == 0) {
+            targets = {random_target(rng, 0), random_target(rng, 1)};
+        }
+        auto state = by_state.get_state();
+        auto snapshot = by_snapshot.get_snapshot();
+        for (int k = 0; k < 5; ++k) {
+            auto a1 = random_target(rng, 0);
+            auto a2 = random_target(rng, 1);
+            by_state.step(a1, a2);
+            by_snapshot.step(a1, a2);
+        }
+        by_state.set_state(state);
+        by_snapshot.restore(snapshot);
+
+        int winner = reference.step(targets[0], targets[1]);
+        by_state.step(targets[0], targets[1]);
+        by_snapshot.step(targets[0], targets[1]);
+        if (!same_bits(by_state.get_state(), reference.get_state())) {
+            ++mismatches[0];
+            by_state = reference;
+        }
+        if (!same_bits(by_snapshot.get_state(), reference.get_state())) {
+            ++mismatches[1];
+            by_snapshot = reference;
+        }
+        if (winner != -1) {
+            sender = 1 - sender;
+            for (auto* env : {&reference, &by_state, &by_snapshot}) {
+                env->reset(sender);
+            }
+        }
+    }
+    return mismatches;
+}
+
+// Three ways of walking the same search tree. Each of them returns the
+// XOR of the state hashes of the leaves, so that they can be compared.
+
+std::uint64_t search_copy(const ash::Environment& env, int depth,
+        size_t& nodes) {
+    if (depth == 0) {
+        return env.get_state_hash();
+    }
+    std::uint64_t out = 0;
+    for (size_t b = 0; b < branching; ++b) {
+        ash::Environment child = env;
+        auto actions = branch(env, b);
+        child.step(actions[0], actions[1]);
+        ++nodes;
+        out ^= search_copy(child, depth - 1, nodes);
+    }
+    return out;
+}
+
+std::uint64_t search_snapshot(ash::Environment& env, int depth,
+        size_t& nodes) {
+    if (depth == 0) {
+        return env.get_state_hash();
+    }
+    std::uint64_t out = 0;
+    auto snapshot = env.get_snapshot();
+    for (size_t b = 0; b < branching; ++b) {
+        auto actions = branch(env, b);
+        env.step(actions[0], actions[1]);
+        ++nodes;
+        out ^= search_snapshot(env, depth - 1, nodes);
+        env.restore(snapshot);
+    }
+    return out;
+}
+
+std::uint64_t search_undo(ash::Undo_log& log, int depth, size_t& nodes) {
+    auto& env = log.get_environment();
+    if (depth == 0) {
+        return env.get_state_hash();
+    }
+    std::uint64_t out = 0;
+    for (size_t b = 0; b < branching; ++b) {
+        auto actions = branch(env, b);
+        log.step(actions[0], actions[1]);
+        ++nodes;
+        out ^= search_undo(log, depth - 1, nodes);
+        log.undo();
+    }
+    return out;
+}
+
+// roots spread over a game
+std::vector<ash::Environment> make_roots(size_t count) {
+    std::mt19937 rng(2);
+    std::vector<ash::Environment> roots;
+    ash::Environment env;
+    size_t sender = 0;
+    while (roots.size() < count) {
+        for (int k = 0; k < 20; ++k) {
+            if (env.step(random_target(rng, 0), random_target(rng, 1)) != -1) {
+                sender = 1 - sender;
+                env.reset(sender);
+            }
+        }
+        roots.push_back(env);
+    }
+    return roots;
+}
+
+struct Report {
+    double node_rate;
+    std::uint64_t hash;
+};
+
+template<class Search>
+Report measure(const std::vector<ash::Environment>& roots, Search search) {
+    size_t nodes = 0;
+    Report report = {0, 0};
+    auto start = Clock::now();
+    for (const auto& root : roots) {
+        report.hash ^= search(root, nodes);
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    report.node_rate = nodes/elapsed.count();
+    return report;
+}
+
+// cost of restoring a snapshot and taking a new one, without stepping
+double measure_snapshot(const std::vector<ash::Environment>& roots,
+        size_t count) {
+    std::vector<ash::Environment::Snapshot> snapshots;
+    for (const auto& root : roots) {
+        snapshots.push_back(root.get_snapshot());
+    }
+    auto env = roots[0];
+    auto start = Clock::now();
+    for (size_t i = 0; i < count; ++i) {
+        env.restore(snapshots[i % snapshots.size()]);
+        snapshots[(i + 1) % snapshots.size()] = env.get_snapshot();
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return elapsed.count()/count*1e9;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    size_t ticks = argc > 1? std::stoul(argv[1]) : 20000;
+    int depth = argc > 2? std::stoi(argv[2]) : 5;
+    size_t root_count = 200;
+
+    auto mismatches = check_restore(ticks);
+    std::cout << ticks << " detours with sleeping bodies: "
+              << mismatches[0] << " mismatches through set_state, "
+              << mismatches[1] << " through snapshots" << std::endl;
+
+    std::cout << "Snapshot: " << sizeof(ash::Environment::Snapshot)
+              << " bytes, Environment: " << sizeof(ash::Environment)
+              << " bytes; snapshot + restore: " << std::setprecision(3)
+              << measure_snapshot(make_roots(64), 10000000) << " ns"
+              << std::endl;
+
+    auto roots = make_roots(root_count);
+    auto copy = measure(roots, [depth](const ash::Environment& root,
+                size_t& nodes) {
+            return search_copy(root, depth, nodes);
+        });
+    auto snapshot = measure(roots, [depth](const ash::Environment& root,
+                size_t& nodes) {
+            auto env = root;
+            return search_snapshot(env, depth, nodes);
+        });
+    auto undo = measure(roots, [depth](const ash::Environment& root,
+                size_t& nodes) {
+            auto env = root;
+            ash::Undo_log log(env);
+            return search_undo(log, depth, nodes);
+        });
+    std::cout << root_count << " searches of depth " << depth
+              << ", branching " << branching << std::endl;
+    std::cout << std::setw(10) << "method"
+              << std::setw(14) << "nodes/s"
+              << std::setw(12) << "ns/node"
+              << std::setw(20) << "leaf hash" << std::endl;
+    for (auto [name, report] : {std::pair<const char*, Report>{"copy", copy},
+            {"snapshot", snapshot}, {"undo log", undo}}) {
+        std::cout << std::setw(10) << name << std::fixed
+                  << std::setw(14) << std::setprecision(0) << report.node_rate
+                  << std::setw(12) << std::setprecision(1)
+                  << 1e9/report.node_rate
+                  << std::setw(20) << std::hex << report.hash << std::dec
+                  << std::endl;
+    }
+    bool same = copy.hash == snapshot.hash && copy.hash == undo.hash;
+    return mismatches[1] == 0 && same? 0 : 1;
+}
@@ -0,0 +1,61 @@
+#include "state_history.hpp"
+
+#include <cassert>
+
+
+int ash::play_tick(Match& match, const Environment::Action& input1,
+        const Environment::Action& input2) {
+    int winner = match.environment.step(input1, input2);
+    if (winner != -1) {
+        ++match.score[winner];
+        match.sender = 1 - match.sender;
+        match.environment.reset(match.sender);
+    }
+    return winner;
+}
+
+ash::State_history::State_history(size_t capacity) :
+    entries(capacity), end(0)
+{
+    assert(capacity > 0);
+}
+
+void ash::State_history::record(const Match& match, const Input_pair& inputs) {
+    auto& entry = entries[end % entries.size()];
+    entry.snapshot = match.environment.get_snapshot();
+    entry.score = match.score;
+    entry.sender = match.sender;
+    entry.inputs = inputs;
+    ++end;
+}
+
+void ash::State_history::set_input(std::uint64_t tick, size_t player,
+        const Action& input) {
+    assert(contains(tick));
+    entries[tick % entries.size()].inputs[player] = input;
+}
+
+void ash::State_history::rewind(std::uint64_t tick, Match& match) const {
+    assert(contains(tick));
+    const auto& entry = entries[tick % entries.size()];
+    match.environment.restore(entry.snapshot);
+    match.score = entry.score;
+    match.sender = entry.sender;
+}
+
+int ash::State_history::resimulate(std::uint64_t tick, Match& match) {
+    rewind(tick, match);
+    int goals = 0;
+    for (auto t = tick; t < end; ++t) {
+        auto& entry = entries[t % entries.size()];
+        if (t != tick) {
+            entry.snapshot = match.environment.get_snapshot();
+            entry.score = match.score;
+            entry.sender = match.sender;
+        }
+        if (play_tick(match, entry.inputs[0], entry.inputs[1]) != -1) {
+            ++goals;
+        }
+    }
+    return goals;
+}
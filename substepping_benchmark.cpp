@@ -0,0 +1,211 @@
+#include "physics.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+typedef ash::Environment::State State;
+typedef ash::Environment::Action Action;
+
+struct Tick {
+    State state;
+    Action actions[2];
+    State next;
+    int winner;
+};
+
+// Stand-in for a human player: guards its goal while the puck is in the
+// other half and strikes it when it comes close. Like a hand on a mouse, it
+// reacts with some delay and aims imperfectly.
+class Scripted_player {
+    public:
+        Scripted_player(size_t side, unsigned seed) :
+            side(side), rng(seed), target(0, 0), striking(false) {
+        }
+
+        Action get_action(const State& state) {
+            using namespace ::ash::parameters;
+            std::bernoulli_distribution react(0.2);
+            std::normal_distribution<double> aim(0, 0.03);
+            if (!react(rng)) {
+                return target;
+            }
+            double sign = side == 0? -1 : 1;
+            const auto& puck = state.puck.position;
+            ash::Vector_2d goal(sign*field_length/2, 0);
+            if (sign*puck.x > 0) {
+                if (!striking) {
+                    striking = true;
+                    offset = ash::Vector_2d(aim(rng), aim(rng));
+                }
+                // strike through the puck, away from the own goal
+                auto direction = puck - goal;
+                target = puck + 0.1/direction.norm()*direction + offset;
+            }
+            else {
+                striking = false;
+                target = ash::Vector_2d(sign*(field_length/2 - 0.15),
+                        puck.y/2);
+            }
+            return target;
+        }
+
+    private:
+        size_t side;
+        std::mt19937 rng;
+        Action target;
+        ash::Vector_2d offset;
+        bool striking;
+};
+
+std::vector<Tick> record_match(unsigned seed, size_t ticks) {
+    ash::Environment env;
+    Scripted_player players[] = {
+        Scripted_player(0, 2*seed), Scripted_player(1, 2*seed + 1)};
+    std::vector<Tick> match(ticks);
+    size_t sender = seed%2;
+    env.reset(sender);
+    for (auto& tick : match) {
+        tick.state = env.get_state();
+        tick.actions[0] = players[0].get_action(tick.state);
+        tick.actions[1] = players[1].get_action(tick.state);
+        tick.winner = env.step(tick.actions[0], tick.actions[1]);
+        if (tick.winner != -1) {
+            sender = 1 - sender;
+            env.reset(sender);
+        }
+        tick.next = env.get_state();
+    }
+    return match;
+}
+
+double distance(const State& a, const State& b) {
+    double out = (a.puck.position - b.puck.position).norm();
+    for (size_t i = 0; i < 2; ++i) {
+        out = std::max(out,
+                (a.mallets[i].position - b.mallets[i].position).norm());
+    }
+    return out;
+}
+
+// the puck has gone through a wall rather than into a goal
+bool escaped(const State& state) {
+    using namespace ::ash::parameters;
+    const auto& puck = state.puck.position;
+    return std::abs(puck.y) > field_width/2 ||
+        (std::abs(puck.x) > field_length/2 && std::abs(puck.y) > goal_width/2);
+}
+
+struct Configuration {
+    const char* name;
+    ash::Environment::Substepping substepping;
+    int fixed_substeps;
+    ash::Environment::Collision_detection collision_detection;
+};
+
+struct Report {
+    double seconds;
+    size_t substeps;
+    double mean_error;
+    double max_error;
+    size_t winner_mismatches;
+    size_t escapes;
+};
+
+// Replays every recorded tick from its recorded state, so that the error
+// reported is the error of a single tick and not the divergence of a whole
+// chaotic match.
+Report replay(const std::vector<std::vector<Tick>>& matches,
+        const Configuration& configuration) {
+    ash::Environment env;
+    env.set_substepping(configuration.substepping);
+    env.set_fixed_substeps(configuration.fixed_substeps);
+    env.set_collision_detection(configuration.collision_detection);
+    Report report = {};
+    size_t count = 0;
+    for (const auto& match : matches) {
+        for (const auto& tick : match) {
+            env.set_state(tick.state);
+            auto start = Clock::now();
+            int winner = env.step(tick.actions[0], tick.actions[1]);
+            std::chrono::duration<double> elapsed = Clock::now() - start;
+            report.seconds += elapsed.count();
+            report.substeps += env.get_last_substeps();
+            if (winner != tick.winner) {
+                ++report.winner_mismatches;
+            }
+            if (escaped(env.get_state())) {
+                ++report.escapes;
+            }
+            if (winner == -1 && tick.winner == -1) {
+                double error = distance(env.get_state(), tick.next);
+                report.mean_error += error;
+                report.max_error = std::max(report.max_error, error);
+                ++count;
+            }
+        }
+    }
+    report.mean_error /= count;
+    return report;
+}
+
+}
+
+
+int main(int argc, char* argv[]) {
+    using Substepping = ash::Environment::Substepping;
+    using Collision_detection = ash::Environment::Collision_detection;
+    size_t match_count = argc > 1? std::stoul(argv[1]) : 20;
+    size_t ticks = argc > 2? std::stoul(argv[2]) : 3000;
+
+    std::vector<std::vector<Tick>> matches;
+    size_t goals = 0;
+    for (size_t i = 0; i < match_count; ++i) {
+        matches.push_back(record_match(i, ticks));
+        for (const auto& tick : matches.back()) {
+            goals += tick.winner != -1;
+        }
+    }
+    size_t total = match_count*ticks;
+    std::cout << match_count << " matches, " << total << " ticks, "
+              << goals << " goals" << std::endl;
+
+    const Configuration configurations[] = {
+        {"fixed 10", Substepping::fixed, 10, Collision_detection::discrete},
+        {"fixed 2", Substepping::fixed, 2, Collision_detection::discrete},
+        {"fixed 2 swept", Substepping::fixed, 2, Collision_detection::swept},
+        {"fixed 1", Substepping::fixed, 1, Collision_detection::discrete},
+        {"fixed 1 swept", Substepping::fixed, 1, Collision_detection::swept},
+        {"adaptive", Substepping::adaptive, 10,
+            Collision_detection::discrete},
+        {"adaptive swept", Substepping::adaptive, 10,
+            Collision_detection::swept},
+    };
+    std::cout << std::setw(16) << "mode"
+              << std::setw(14) << "substeps/tick"
+              << std::setw(10) << "ns/tick"
+              << std::setw(15) << "mean err (mm)"
+              << std::setw(14) << "max err (mm)"
+              << std::setw(12) << "goal diffs"
+              << std::setw(9) << "escapes" << std::endl;
+    for (const auto& configuration : configurations) {
+        auto report = replay(matches, configuration);
+        std::cout << std::fixed
+                  << std::setw(16) << configuration.name
+                  << std::setw(14) << std::setprecision(2)
+                  << static_cast<double>(report.substeps)/total
+                  << std::setw(10) << std::setprecision(0)
+                  << report.seconds/total*1e9
+                  << std::setw(15) << std::setprecision(4)
+                  << report.mean_error*1e3
+                  << std::setw(14) << report.max_error*1e3
+                  << std::setw(12) << report.winner_mismatches
+                  << std::setw(9) << report.escapes << std::endl;
+    }
+}
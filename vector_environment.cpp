@@ -0,0 +1,445 @@
+#include "vector_environment.hpp"
+
+#include <algorithm>
+#include <random>
+
+
+namespace {
+
+// tables are simulated in blocks small enough for all their lanes to stay
+// in L1 during the ten substeps of a tick
+constexpr size_t block_size = 128;
+
+template<bool exact>
+void integrate_mallet(size_t begin, size_t end,
+        double* __restrict x, double* __restrict y,
+        double* __restrict vx, double* __restrict vy,
+        const double* __restrict tx, const double* __restrict ty,
+        const double* __restrict kp, const double* __restrict kd,
+        const double* __restrict max_p_force,
+        const double* __restrict inv_mass) {
+    using namespace ::ash::parameters;
+
+    for (size_t i = begin; i < end; ++i) {
+        // PD control, see pd_control in physics.cpp
+        double px = (tx[i] - x[i])*kp[i];
+        double py = (ty[i] - y[i])*kp[i];
+        double p_mag_sq = px*px + py*py;
+        // both candidates are computed before selecting one of them, so
+        // that the loop is free of branches and vectorizes
+        double scale = max_p_force[i]/sqrt(p_mag_sq);
+        double px_saturated = px*scale;
+        double py_saturated = py*scale;
+        bool saturated = p_mag_sq > max_p_force[i]*max_p_force[i];
+        px = saturated? px_saturated : px;
+        py = saturated? py_saturated : py;
+        double fx = px + vx[i]*(-kd[i]);
+        double fy = py + vy[i]*(-kd[i]);
+        double vxi, vyi;
+        if constexpr (exact) {
+            // force accumulator starts at zero
+            fx = 0.0 + fx;
+            fy = 0.0 + fy;
+            vxi = vx[i] + (fx*inv_mass[i])*substep_dt;
+            vyi = vy[i] + (fy*inv_mass[i])*substep_dt;
+        }
+        else {
+            double impulse = inv_mass[i]*substep_dt;
+            vxi = vx[i] + fx*impulse;
+            vyi = vy[i] + fy*impulse;
+        }
+        vx[i] = vxi;
+        vy[i] = vyi;
+        x[i] += vxi*substep_dt;
+        y[i] += vyi*substep_dt;
+    }
+}
+
+template<bool exact>
+void integrate_puck(size_t begin, size_t end,
+        double* __restrict x, double* __restrict y,
+        double* __restrict vx, double* __restrict vy,
+        const double* __restrict friction_dec,
+        const double* __restrict inv_mass) {
+    using namespace ::ash::parameters;
+
+    for (size_t i = begin; i < end; ++i) {
+        double vxi = vx[i];
+        double vyi = vy[i];
+        double velocity_mag = sqrt(vxi*vxi + vyi*vyi);
+        double velocity_dec = velocity_mag < friction_dec[i]?
+            velocity_mag : friction_dec[i];
+        double scale = velocity_dec/velocity_mag;
+        double vx_dec = vxi - vxi*scale;
+        double vy_dec = vyi - vyi*scale;
+        bool moving = velocity_mag > 0;
+        vxi = moving? vx_dec : vxi;
+        vyi = moving? vy_dec : vyi;
+        if constexpr (exact) {
+            // the puck never receives forces
+            vxi += (0.0*inv_mass[i])*substep_dt;
+            vyi += (0.0*inv_mass[i])*substep_dt;
+        }
+        vx[i] = vxi;
+        vy[i] = vyi;
+        x[i] += vxi*substep_dt;
+        y[i] += vyi*substep_dt;
+    }
+}
+
+// Collision kernels run in two passes. The first one is the broadphase,
+// a branch-free AABB test over the whole block that the compiler
+// vectorizes (the flags are doubles because SSE2 has no cheap way of
+// narrowing a double comparison). Contacts are rare, so the narrow phase
+// and the response only run, lane by lane, for the flagged tables.
+
+void collide_box_vs_disk(size_t begin, size_t end, const ash::AABB& box,
+        double* __restrict x, double* __restrict y,
+        double* __restrict vx, double* __restrict vy,
+        const double* __restrict radius, const double* __restrict inv_mass,
+        const double* __restrict restitution) {
+    using namespace ::ash::parameters;
+    // local copies, so that the compiler does not need to reload them
+    const double x_min = box.x_min;
+    const double x_max = box.x_max;
+    const double y_min = box.y_min;
+    const double y_max = box.y_max;
+
+    std::array<double, block_size> overlap;
+    for (size_t i = begin; i < end; ++i) {
+        bool o = (x_max > x[i] - radius[i]) &
+                 (x[i] + radius[i] > x_min) &
+                 (y_max > y[i] - radius[i]) &
+                 (y[i] + radius[i] > y_min);
+        overlap[i-begin] = o? 1.0 : 0.0;
+    }
+
+    const ash::Vector_2d v1(x_max-x_min, y_max-y_min);
+    const ash::Vector_2d v2(x_max-x_min, y_min-y_max);
+    for (size_t i = begin; i < end; ++i) {
+        if (overlap[i-begin] == 0) {
+            continue;
+        }
+        // narrow phase, see collides_box_vs_disk in physics.cpp
+        ash::Vector_2d pos(x[i], y[i]);
+        ash::Vector_2d u1(pos.x-x_min, pos.y-y_min);
+        ash::Vector_2d u2(pos.x-x_min, pos.y-y_max);
+        bool ab = v1.x*u1.y - v1.y*u1.x > 0;
+        bool bc = v2.x*u2.y - v2.y*u2.x > 0;
+        ash::Vector_2d closest;
+        ash::Vector_2d normal;
+        if (ab == bc) {
+            closest = ash::Vector_2d(ash::clamp(pos.x, x_min, x_max),
+                    ab? y_max : y_min);
+            normal = ash::Vector_2d(0, ab? 1 : -1);
+        }
+        else {
+            closest = ash::Vector_2d(bc? x_max : x_min,
+                    ash::clamp(pos.y, y_min, y_max));
+            normal = ash::Vector_2d(bc? 1 : -1, 0);
+        }
+        auto closest_to_disk = pos - closest;
+        double distance = closest_to_disk.norm_sq();
+        bool inside = x_min < pos.x && pos.x < x_max &&
+                      y_min < pos.y && pos.y < y_max;
+        if (!inside && distance >= radius[i]*radius[i]) {
+            continue;
+        }
+        distance = sqrt(distance);
+        if (distance != 0) {
+            normal = closest_to_disk/distance;
+        }
+        double penetration = inside? (radius[i] + distance) :
+            (radius[i] - distance);
+
+        // response, see resolve_collision and correct_position. The box is
+        // static (zero inverse mass and velocity), so the disk takes the
+        // whole impulse and the whole positional correction.
+        double w = inv_mass[i]/(0.0 + inv_mass[i]);
+        ash::Vector_2d velocity(vx[i], vy[i]);
+        double v_ab_n = normal.dot(velocity);
+        if (v_ab_n < 0) {
+            velocity -= (w*(1+restitution[i])*v_ab_n) * normal;
+            vx[i] = velocity.x;
+            vy[i] = velocity.y;
+        }
+        if (penetration >= slop) {
+            pos += (w*positional_correction*penetration) * normal;
+            x[i] = pos.x;
+            y[i] = pos.y;
+        }
+    }
+}
+
+void collide_disk_vs_disk(size_t begin, size_t end,
+        double* __restrict ax, double* __restrict ay,
+        double* __restrict avx, double* __restrict avy,
+        const double* __restrict radius_a,
+        const double* __restrict inv_mass_a,
+        double* __restrict bx, double* __restrict by,
+        double* __restrict bvx, double* __restrict bvy,
+        const double* __restrict radius_b,
+        const double* __restrict inv_mass_b,
+        const double* __restrict restitution) {
+    using namespace ::ash::parameters;
+    std::array<double, block_size> overlap;
+    for (size_t i = begin; i < end; ++i) {
+        bool o = (ax[i] + radius_a[i] > bx[i] - radius_b[i]) &
+                 (bx[i] + radius_b[i] > ax[i] - radius_a[i]) &
+                 (ay[i] + radius_a[i] > by[i] - radius_b[i]) &
+                 (by[i] + radius_b[i] > ay[i] - radius_a[i]);
+        overlap[i-begin] = o? 1.0 : 0.0;
+    }
+
+    for (size_t i = begin; i < end; ++i) {
+        if (overlap[i-begin] == 0) {
+            continue;
+        }
+        const double sum_radius = radius_a[i] + radius_b[i];
+        // narrow phase, see collides_disk_vs_disk in physics.cpp
+        ash::Vector_2d pos_a(ax[i], ay[i]);
+        ash::Vector_2d pos_b(bx[i], by[i]);
+        auto displacement = pos_b - pos_a;
+        double distance_sq = displacement.norm_sq();
+        if (distance_sq >= sum_radius*sum_radius) {
+            continue;
+        }
+        double distance = sqrt(distance_sq);
+        double penetration = sum_radius - distance;
+        ash::Vector_2d normal = distance_sq == 0?
+            ash::Vector_2d(1,0) :
+            displacement/distance;
+
+        // response, see resolve_collision and correct_position
+        double den = inv_mass_a[i] + inv_mass_b[i];
+        double w1 = inv_mass_a[i] / den;
+        double w2 = inv_mass_b[i] / den;
+        ash::Vector_2d v_a(avx[i], avy[i]);
+        ash::Vector_2d v_b(bvx[i], bvy[i]);
+        double v_ab_n = normal.dot(v_b - v_a);
+        if (v_ab_n < 0) {
+            v_a += (w1*(1+restitution[i])*v_ab_n) * normal;
+            v_b -= (w2*(1+restitution[i])*v_ab_n) * normal;
+            avx[i] = v_a.x;
+            avy[i] = v_a.y;
+            bvx[i] = v_b.x;
+            bvy[i] = v_b.y;
+        }
+        if (penetration >= slop) {
+            pos_a -= w1*positional_correction*penetration * normal;
+            pos_b += w2*positional_correction*penetration * normal;
+            ax[i] = pos_a.x;
+            ay[i] = pos_a.y;
+            bx[i] = pos_b.x;
+            by[i] = pos_b.y;
+        }
+    }
+}
+
+}
+
+ash::Vector_environment::Vector_environment(size_t size, Mode mode) :
+    n(size), mode(mode)
+{
+    // take the static geometry from a scalar environment, so that both
+    // implementations see exactly the same bounding boxes
+    Environment prototype;
+    for (size_t i = 0; i < walls.size(); ++i) {
+        walls[i] = prototype.get_walls()[i].get_bounding_box();
+    }
+    for (size_t i = 0; i < barriers.size(); ++i) {
+        barriers[i] = prototype.get_barriers()[i].get_bounding_box();
+    }
+    for (auto& mallet : mallets) {
+        mallet.resize(n);
+    }
+    puck.resize(n);
+    lanes.resize(n);
+    sets.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        set_parameters(i, default_parameters);
+    }
+    for (size_t i = 0; i < 2; ++i) {
+        target_x[i].resize(n);
+        target_y[i].resize(n);
+    }
+    winners.resize(n, -1);
+    for (size_t i = 0; i < n; ++i) {
+        reset(i, 0);
+    }
+}
+
+void ash::Vector_environment::reset(size_t table, size_t sender) {
+    using namespace ::ash::parameters;
+    double d = field_length - 2*lanes.mallet_radius[table];
+    for (size_t i = 0; i < 2; ++i) {
+        mallets[i].x[table] = -d/2 + i*d;
+        mallets[i].y[table] = 0;
+        mallets[i].vx[table] = 0;
+        mallets[i].vy[table] = 0;
+    }
+    double e = field_length/2;
+    puck.x[table] = -e/2 + sender*e;
+    puck.y[table] = 0;
+    puck.vx[table] = 0;
+    puck.vy[table] = 0;
+}
+
+ash::Parameter_set ash::Vector_environment::Randomization::sample(
+        std::uint64_t seed) const {
+    std::mt19937_64 rng(seed);
+    auto draw = [&](const Range& range) {
+        // 53 random bits, scaled to [0, 1) exactly
+        double u = static_cast<double>(rng() >> 11)*0x1p-53;
+        return range.min + (range.max - range.min)*u;
+    };
+    Parameter_set set = default_parameters;
+    set.mallet_wall_restitution = draw(mallet_wall_restitution);
+    set.mallet_puck_restitution = draw(mallet_puck_restitution);
+    set.puck_wall_restitution = draw(puck_wall_restitution);
+    set.puck_mu = draw(puck_mu);
+    set.mallet_mass = draw(mallet_mass);
+    set.puck_mass = draw(puck_mass);
+    set.kp = draw(kp);
+    set.kd = draw(kd);
+    set.mallet_radius = draw(mallet_radius);
+    set.puck_radius = draw(puck_radius);
+    return set;
+}
+
+void ash::Vector_environment::set_parameters(size_t table,
+        const Parameter_set& set) {
+    // same arithmetic as the Body constructor and Environment::integrate
+    sets[table] = set;
+    lanes.kp[table] = set.kp;
+    lanes.kd[table] = set.kd;
+    lanes.max_p_force[table] = set.kd*set.mallet_max_velocity;
+    lanes.mallet_radius[table] = set.mallet_radius;
+    lanes.mallet_inv_mass[table] = 1.0/set.mallet_mass;
+    lanes.puck_radius[table] = set.puck_radius;
+    lanes.puck_inv_mass[table] = 1.0/set.puck_mass;
+    lanes.friction_dec[table] = set.gravity*set.puck_mu*set.substep_dt();
+    lanes.mallet_wall_restitution[table] = set.mallet_wall_restitution;
+    lanes.mallet_puck_restitution[table] = set.mallet_puck_restitution;
+    lanes.puck_wall_restitution[table] = set.puck_wall_restitution;
+}
+
+void ash::Vector_environment::randomize(const Randomization& randomization,
+        std::uint64_t seed) {
+    for (size_t i = 0; i < n; ++i) {
+        set_parameters(i, randomization.sample(seed + i));
+    }
+}
+
+const std::vector<int>& ash::Vector_environment::step(
+        const std::vector<Action_pair>& actions) {
+    using namespace ::ash::parameters;
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < 2; ++j) {
+            target_x[j][i] = actions[i][j].x;
+            target_y[j][i] = actions[i][j].y;
+        }
+    }
+    for (size_t begin = 0; begin < n; begin += block_size) {
+        size_t end = std::min(n, begin + block_size);
+        for (int i = 0; i < substeps; ++i) {
+            if (mode == Mode::reference) {
+                substep<true>(begin, end);
+            }
+            else {
+                substep<false>(begin, end);
+            }
+        }
+    }
+    check_goals();
+    return winners;
+}
+
+ash::Environment::State ash::Vector_environment::get_state(
+        size_t table) const {
+    Environment::State state;
+    for (size_t i = 0; i < 2; ++i) {
+        state.mallets[i].position = Vector_2d(
+                mallets[i].x[table], mallets[i].y[table]);
+        state.mallets[i].velocity = Vector_2d(
+                mallets[i].vx[table], mallets[i].vy[table]);
+    }
+    state.puck.position = Vector_2d(puck.x[table], puck.y[table]);
+    state.puck.velocity = Vector_2d(puck.vx[table], puck.vy[table]);
+    return state;
+}
+
+void ash::Vector_environment::set_state(size_t table,
+        const Environment::State& state) {
+    for (size_t i = 0; i < 2; ++i) {
+        mallets[i].x[table] = state.mallets[i].position.x;
+        mallets[i].y[table] = state.mallets[i].position.y;
+        mallets[i].vx[table] = state.mallets[i].velocity.x;
+        mallets[i].vy[table] = state.mallets[i].velocity.y;
+    }
+    puck.x[table] = state.puck.position.x;
+    puck.y[table] = state.puck.position.y;
+    puck.vx[table] = state.puck.velocity.x;
+    puck.vy[table] = state.puck.velocity.y;
+}
+
+template<bool exact>
+void ash::Vector_environment::substep(size_t begin, size_t end) {
+    for (size_t j = 0; j < 2; ++j) {
+        integrate_mallet<exact>(begin, end,
+                mallets[j].x.data(), mallets[j].y.data(),
+                mallets[j].vx.data(), mallets[j].vy.data(),
+                target_x[j].data(), target_y[j].data(),
+                lanes.kp.data(), lanes.kd.data(), lanes.max_p_force.data(),
+                lanes.mallet_inv_mass.data());
+    }
+    integrate_puck<exact>(begin, end,
+            puck.x.data(), puck.y.data(), puck.vx.data(), puck.vy.data(),
+            lanes.friction_dec.data(), lanes.puck_inv_mass.data());
+
+    // same pair order as Environment::substep. Mallets are independent of
+    // each other when colliding against static boxes, so all the boxes
+    // can be handled for one mallet before moving to the next one.
+    for (auto& mallet : mallets) {
+        for (const auto& wall : walls) {
+            collide_box_vs_disk(begin, end, wall,
+                    mallet.x.data(), mallet.y.data(),
+                    mallet.vx.data(), mallet.vy.data(),
+                    lanes.mallet_radius.data(), lanes.mallet_inv_mass.data(),
+                    lanes.mallet_wall_restitution.data());
+        }
+        for (const auto& barrier : barriers) {
+            collide_box_vs_disk(begin, end, barrier,
+                    mallet.x.data(), mallet.y.data(),
+                    mallet.vx.data(), mallet.vy.data(),
+                    lanes.mallet_radius.data(), lanes.mallet_inv_mass.data(),
+                    lanes.mallet_wall_restitution.data());
+        }
+    }
+    for (const auto& wall : walls) {
+        collide_box_vs_disk(begin, end, wall,
+                puck.x.data(), puck.y.data(), puck.vx.data(), puck.vy.data(),
+                lanes.puck_radius.data(), lanes.puck_inv_mass.data(),
+                lanes.puck_wall_restitution.data());
+    }
+    for (auto& mallet : mallets) {
+        collide_disk_vs_disk(begin, end,
+                mallet.x.data(), mallet.y.data(),
+                mallet.vx.data(), mallet.vy.data(),
+                lanes.mallet_radius.data(), lanes.mallet_inv_mass.data(),
+                puck.x.data(), puck.y.data(), puck.vx.data(), puck.vy.data(),
+                lanes.puck_radius.data(), lanes.puck_inv_mass.data(),
+                lanes.mallet_puck_restitution.data());
+    }
+}
+
+void ash::Vector_environment::check_goals() {
+    using namespace ::ash::parameters;
+    const double* __restrict x = puck.x.data();
+    const double* __restrict radius = lanes.puck_radius.data();
+    for (size_t i = 0; i < n; ++i) {
+        double goal_threshold = field_length/2 + radius[i];
+        winners[i] = x[i] < -goal_threshold? 1 :
+            (x[i] > goal_threshold? 0 : -1);
+    }
+}
@@ -0,0 +1,191 @@
+#include "benchmark_support.hpp"
+#include "vector_environment.hpp"
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <type_traits>
+
+
+namespace {
+
+typedef ash::benchmark::Clock Clock;
+typedef ash::Vector_environment::Action_pair Action_pair;
+using ash::benchmark::same_bits;
+
+ash::Environment::State random_state(std::mt19937& rng) {
+    using namespace ::ash::parameters;
+    std::uniform_real_distribution<double> x(
+            -field_length/2 + mallet_radius, field_length/2 - mallet_radius);
+    std::uniform_real_distribution<double> y(
+            -field_width/2 + mallet_radius, field_width/2 - mallet_radius);
+    std::uniform_real_distribution<double> v(-3, 3);
+    ash::Environment::State state;
+    for (size_t i = 0; i < 2; ++i) {
+        double side = i == 0? -1 : 1;
+        state.mallets[i].position = ash::Vector_2d(
+                side*std::abs(x(rng)), y(rng));
+        state.mallets[i].velocity = ash::Vector_2d(v(rng), v(rng));
+    }
+    state.puck.position = ash::Vector_2d(x(rng), y(rng));
+    state.puck.velocity = ash::Vector_2d(v(rng), v(rng));
+    return state;
+}
+
+// mallets chase the puck with some noise, so that every collision pair
+// shows up during the run
+Action_pair random_actions(const ash::Environment::State& state,
+        std::mt19937& rng) {
+    std::normal_distribution<double> noise(0, 0.1);
+    Action_pair actions;
+    for (size_t i = 0; i < 2; ++i) {
+        actions[i] = state.puck.position +
+            ash::Vector_2d(noise(rng), noise(rng));
+    }
+    return actions;
+}
+
+// a spread of about 20% around the nominal values
+ash::Vector_environment::Randomization make_randomization() {
+    ash::Vector_environment::Randomization randomization;
+    randomization.mallet_wall_restitution = {0.1, 0.3};
+    randomization.mallet_puck_restitution = {0.5, 0.7};
+    randomization.puck_wall_restitution = {0.8, 0.95};
+    randomization.puck_mu = {0.005, 0.02};
+    randomization.mallet_mass = {0.15, 0.19};
+    randomization.puck_mass = {0.013, 0.017};
+    randomization.kp = {120, 180};
+    randomization.kd = {8, 12};
+    randomization.mallet_radius = {0.046, 0.05};
+    randomization.puck_radius = {0.030, 0.033};
+    return randomization;
+}
+
+// Against Environment the tables keep the default parameters; against
+// Runtime_environment they are randomized, and every scalar table gets the
+// parameters of its vectorized twin.
+template<class Environment>
+size_t check_reference_mode(size_t tables, size_t ticks) {
+    constexpr bool randomized =
+        std::is_same_v<Environment, ash::Runtime_environment>;
+    std::mt19937 rng(42);
+    ash::Vector_environment vectorized(tables,
+            ash::Vector_environment::Mode::reference);
+    std::vector<Environment> scalar(tables);
+    if constexpr (randomized) {
+        vectorized.randomize(make_randomization(), 1);
+        for (size_t i = 0; i < tables; ++i) {
+            scalar[i] = Environment(vectorized.get_parameters(i));
+        }
+    }
+    for (size_t i = 0; i < tables; ++i) {
+        auto state = random_state(rng);
+        scalar[i].set_state(state);
+        vectorized.set_state(i, state);
+    }
+    std::vector<Action_pair> actions(tables);
+    std::vector<size_t> senders(tables, 0);
+    size_t mismatches = 0;
+    for (size_t t = 0; t < ticks; ++t) {
+        for (size_t i = 0; i < tables; ++i) {
+            actions[i] = random_actions(scalar[i].get_state(), rng);
+        }
+        const auto& winners = vectorized.step(actions);
+        for (size_t i = 0; i < tables; ++i) {
+            int winner = scalar[i].step(actions[i][0], actions[i][1]);
+            if (winner != winners[i] ||
+                    !same_bits(scalar[i].get_state(),
+                        vectorized.get_state(i))) {
+                ++mismatches;
+                vectorized.set_state(i, scalar[i].get_state());
+            }
+            if (winner != -1) {
+                senders[i] = 1 - senders[i];
+                scalar[i].reset(senders[i]);
+                vectorized.reset(i, senders[i]);
+            }
+        }
+    }
+    return mismatches;
+}
+
+template<class Step>
+double measure(size_t tables, Step&& step) {
+    // aim for roughly the same amount of work for every batch size
+    size_t ticks = std::max<size_t>(20, 200000/tables);
+    auto start = Clock::now();
+    for (size_t t = 0; t < ticks; ++t) {
+        step();
+    }
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+    return ticks*tables/elapsed.count();
+}
+
+void benchmark(size_t tables) {
+    std::mt19937 rng(1);
+    std::vector<ash::Environment> scalar(tables);
+    ash::Vector_environment reference(tables,
+            ash::Vector_environment::Mode::reference);
+    ash::Vector_environment fast(tables,
+            ash::Vector_environment::Mode::fast);
+    ash::Vector_environment randomized(tables,
+            ash::Vector_environment::Mode::reference);
+    randomized.randomize(make_randomization(), 1);
+    std::vector<Action_pair> actions(tables);
+    for (size_t i = 0; i < tables; ++i) {
+        auto state = random_state(rng);
+        scalar[i].set_state(state);
+        reference.set_state(i, state);
+        fast.set_state(i, state);
+        randomized.set_state(i, state);
+        actions[i] = random_actions(state, rng);
+    }
+
+    double scalar_rate = measure(tables, [&] {
+        for (size_t i = 0; i < tables; ++i) {
+            scalar[i].step(actions[i][0], actions[i][1]);
+        }
+    });
+    double reference_rate = measure(tables, [&] {
+        reference.step(actions);
+    });
+    double fast_rate = measure(tables, [&] {
+        fast.step(actions);
+    });
+    double randomized_rate = measure(tables, [&] {
+        randomized.step(actions);
+    });
+
+    std::cout << std::setw(8) << tables
+              << std::setw(16) << scalar_rate
+              << std::setw(16) << reference_rate
+              << std::setw(16) << fast_rate
+              << std::setw(16) << randomized_rate << std::endl;
+}
+
+}
+
+
+int main() {
+    size_t mismatches = check_reference_mode<ash::Environment>(256, 500);
+    std::cout << "Reference mode vs Environment::step: "
+              << mismatches << " mismatching table ticks" << std::endl;
+    size_t randomized_mismatches =
+        check_reference_mode<ash::Runtime_environment>(256, 500);
+    std::cout << "Randomized tables vs Runtime_environment::step: "
+              << randomized_mismatches << " mismatching table ticks"
+              << std::endl;
+    mismatches += randomized_mismatches;
+
+    std::cout << std::fixed << std::setprecision(0)
+              << std::setw(8) << "tables"
+              << std::setw(16) << "scalar step/s"
+              << std::setw(16) << "reference st/s"
+              << std::setw(16) << "fast step/s"
+              << std::setw(16) << "randomized st/s" << std::endl;
+    for (size_t tables : {1, 4, 16, 64, 256, 1024, 4096}) {
+        benchmark(tables);
+    }
+    return mismatches == 0? 0 : 1;
+}
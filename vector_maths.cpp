@@ -1,6 +1,11 @@
 #include "vector_maths.hpp"
 
 
-std::ostream& ash::operator<<(std::ostream& out, const Vector_2d& v) {
+template<class Scalar>
+std::ostream& ash::operator<<(std::ostream& out,
+        const Basic_vector_2d<Scalar>& v) {
     return out << '(' << v.x << ',' << v.y << ')';
 }
+
+template std::ostream& ash::operator<<(std::ostream&, const Vector_2d&);
+template std::ostream& ash::operator<<(std::ostream&, const Vector_2f&);
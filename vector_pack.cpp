@@ -0,0 +1,172 @@
+#include "vector_pack.hpp"
+
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define ASH_X86 1
+#include <immintrin.h>
+#endif
+
+
+namespace {
+
+// Every kernel does, lane by lane, the operations of Vector_2d in the same
+// order. This file is built without contraction of multiplications and
+// additions into fused ones (see the Makefile), which AVX-512 would allow.
+
+void norm_scalar(const double* x, const double* y, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = std::sqrt(x[i]*x[i] + y[i]*y[i]);
+    }
+}
+
+void normalize_scalar(const double* x, const double* y, double* out_x,
+        double* out_y, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        double norm = std::sqrt(x[i]*x[i] + y[i]*y[i]);
+        out_x[i] = x[i]/norm;
+        out_y[i] = y[i]/norm;
+    }
+}
+
+void dot_scalar(const double* x1, const double* y1, const double* x2,
+        const double* y2, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = x1[i]*x2[i] + y1[i]*y2[i];
+    }
+}
+
+#if defined(ASH_X86)
+
+// The kernels of an instruction set: whole registers first, and the
+// remaining vectors through the scalar kernels.
+#define ASH_SIMD_KERNELS(isa, target_isa, Register, suffix) \
+__attribute__((target(target_isa))) \
+void norm_##isa(const double* x, const double* y, double* out, size_t n) { \
+    constexpr size_t width = sizeof(Register)/sizeof(double); \
+    size_t i = 0; \
+    for (; i + width <= n; i += width) { \
+        Register vx = _mm##suffix##_loadu_pd(x + i); \
+        Register vy = _mm##suffix##_loadu_pd(y + i); \
+        Register norm_sq = _mm##suffix##_add_pd( \
+                _mm##suffix##_mul_pd(vx, vx), _mm##suffix##_mul_pd(vy, vy)); \
+        _mm##suffix##_storeu_pd(out + i, _mm##suffix##_sqrt_pd(norm_sq)); \
+    } \
+    norm_scalar(x + i, y + i, out + i, n - i); \
+} \
+\
+__attribute__((target(target_isa))) \
+void normalize_##isa(const double* x, const double* y, double* out_x, \
+        double* out_y, size_t n) { \
+    constexpr size_t width = sizeof(Register)/sizeof(double); \
+    size_t i = 0; \
+    for (; i + width <= n; i += width) { \
+        Register vx = _mm##suffix##_loadu_pd(x + i); \
+        Register vy = _mm##suffix##_loadu_pd(y + i); \
+        Register norm = _mm##suffix##_sqrt_pd(_mm##suffix##_add_pd( \
+                _mm##suffix##_mul_pd(vx, vx), _mm##suffix##_mul_pd(vy, vy))); \
+        _mm##suffix##_storeu_pd(out_x + i, _mm##suffix##_div_pd(vx, norm)); \
+        _mm##suffix##_storeu_pd(out_y + i, _mm##suffix##_div_pd(vy, norm)); \
+    } \
+    normalize_scalar(x + i, y + i, out_x + i, out_y + i, n - i); \
+} \
+\
+__attribute__((target(target_isa))) \
+void dot_##isa(const double* x1, const double* y1, const double* x2, \
+        const double* y2, double* out, size_t n) { \
+    constexpr size_t width = sizeof(Register)/sizeof(double); \
+    size_t i = 0; \
+    for (; i + width <= n; i += width) { \
+        Register xx = _mm##suffix##_mul_pd(_mm##suffix##_loadu_pd(x1 + i), \
+                _mm##suffix##_loadu_pd(x2 + i)); \
+        Register yy = _mm##suffix##_mul_pd(_mm##suffix##_loadu_pd(y1 + i), \
+                _mm##suffix##_loadu_pd(y2 + i)); \
+        _mm##suffix##_storeu_pd(out + i, _mm##suffix##_add_pd(xx, yy)); \
+    } \
+    dot_scalar(x1 + i, y1 + i, x2 + i, y2 + i, out + i, n - i); \
+}
+
+ASH_SIMD_KERNELS(sse2, "sse2", __m128d, )
+ASH_SIMD_KERNELS(avx2, "avx2", __m256d, 256)
+// _mm512_sqrt_pd starts from an undefined register, which GCC 12 takes for
+// an uninitialized variable
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+ASH_SIMD_KERNELS(avx512, "avx512f", __m512d, 512)
+#pragma GCC diagnostic pop
+
+#undef ASH_SIMD_KERNELS
+
+#endif
+
+const ash::Simd_kernels scalar_kernels = {ash::Simd_isa::scalar,
+    norm_scalar, normalize_scalar, dot_scalar};
+
+#if defined(ASH_X86)
+const ash::Simd_kernels sse2_kernels = {ash::Simd_isa::sse2,
+    norm_sse2, normalize_sse2, dot_sse2};
+const ash::Simd_kernels avx2_kernels = {ash::Simd_isa::avx2,
+    norm_avx2, normalize_avx2, dot_avx2};
+const ash::Simd_kernels avx512_kernels = {ash::Simd_isa::avx512,
+    norm_avx512, normalize_avx512, dot_avx512};
+#endif
+
+}
+
+
+const char* ash::get_name(Simd_isa isa) {
+    switch (isa) {
+        case Simd_isa::sse2:
+            return "sse2";
+        case Simd_isa::avx2:
+            return "avx2";
+        case Simd_isa::avx512:
+            return "avx512";
+        default:
+            return "scalar";
+    }
+}
+
+bool ash::is_supported(Simd_isa isa) {
+    switch (isa) {
+        case Simd_isa::scalar:
+            return true;
+#if defined(ASH_X86)
+        case Simd_isa::sse2:
+            return __builtin_cpu_supports("sse2");
+        case Simd_isa::avx2:
+            return __builtin_cpu_supports("avx2");
+        case Simd_isa::avx512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return false;
+    }
+}
+
+const ash::Simd_kernels& ash::get_simd_kernels(Simd_isa isa) {
+    switch (isa) {
+#if defined(ASH_X86)
+        case Simd_isa::sse2:
+            return sse2_kernels;
+        case Simd_isa::avx2:
+            return avx2_kernels;
+        case Simd_isa::avx512:
+            return avx512_kernels;
+#endif
+        default:
+            return scalar_kernels;
+    }
+}
+
+const ash::Simd_kernels& ash::get_simd_kernels() {
+    static const Simd_kernels& best = [] () -> const Simd_kernels& {
+        for (auto isa : {Simd_isa::avx512, Simd_isa::avx2, Simd_isa::sse2}) {
+            if (is_supported(isa)) {
+                return get_simd_kernels(isa);
+            }
+        }
+        return scalar_kernels;
+    }();
+    return best;
+}